@@ -0,0 +1,176 @@
+/* *****************************************************************************
+ * Arduino.h (native) **********************************************************
+ * *****************************************************************************
+ * ARDUINO CORE SHIM FOR THE HOST BUILD [env:native]
+ *
+ * Covers what the firmware uses: time, digital and analog pins, Serial and
+ * Serial2 as in-memory streams, flash access (PROGMEM is plain memory) and
+ * timer interrupts (see native_hal.h).
+ *
+ * Differences to the ATmega2560: int has 32 bits, long may have 64 bits,
+ * there are no registers, interrupts run between two calls of loop() or
+ * inside delay().
+ * *****************************************************************************
+ */
+
+#ifndef NativeArduino_H_
+#define NativeArduino_H_
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define NOT_A_PIN 0
+#define NOT_A_PORT 0
+#define NUM_DIGITAL_PINS 70
+
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+#define A8 62
+#define A9 63
+#define A10 64
+#define A11 65
+#define A12 66
+#define A13 67
+#define A14 68
+#define A15 69
+
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bit(b) (1UL << (b))
+#define _BV(b) (1 << (b))
+
+#define interrupts()
+#define noInterrupts()
+
+// TIME ------------------------------------------------------------------------
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// PINS ------------------------------------------------------------------------
+// Pin n is bit (n % 8) of port (n / 8 + 1), ports 1..9 like PA..PL.
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+int analogRead(uint8_t pin);
+
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+volatile uint8_t *portOutputRegister(uint8_t port);
+volatile uint8_t *portInputRegister(uint8_t port);
+volatile uint8_t *portModeRegister(uint8_t port);
+
+// STRINGS ---------------------------------------------------------------------
+char *ltoa(long value, char *buffer, int radix);
+char *ultoa(unsigned long value, char *buffer, int radix);
+char *itoa(int value, char *buffer, int radix);
+
+// PRINT AND STREAM ------------------------------------------------------------
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t data) = 0;
+  virtual int availableForWrite() { return 0; }
+  size_t write(const char *text);
+  size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const __FlashStringHelper *text);
+  size_t print(const char *text);
+  size_t print(char character);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println();
+  template <class T> size_t println(T value) { return print(value) + println(); }
+  template <class T> size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+// In-memory serial port. Received bytes are put in with inject(), sent bytes
+// are collected and taken out with take_output() (or echoed to stdout).
+class HardwareSerial : public Stream {
+public:
+  HardwareSerial();
+  void begin(unsigned long baud);
+  void end();
+  operator bool() { return true; }
+
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t data);
+  int availableForWrite();
+  using Print::write;
+
+  void inject(const uint8_t *data, size_t size);
+  void inject(const char *text);
+  size_t take_output(uint8_t *buffer, size_t size);
+  size_t get_output_count();
+  void set_echo(bool is_echoed); // write sent bytes to stdout
+
+private:
+  enum { BUFFER_SIZE = 1024 };
+  uint8_t _input[BUFFER_SIZE];
+  size_t _input_head;
+  size_t _input_tail;
+  uint8_t _output[BUFFER_SIZE];
+  size_t _output_tail;
+  size_t _output_count;
+  bool _is_echoed;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+// SKETCH ----------------------------------------------------------------------
+void setup();
+void loop();
+
+#endif /* NativeArduino_H_ */
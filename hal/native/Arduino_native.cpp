@@ -0,0 +1,405 @@
+/*******************************************************************************
+ * Arduino_native.cpp **********************************************************
+ *******************************************************************************/
+
+#include <chrono> // before Arduino.h, which defines min() and max()
+#include <stdio.h>
+#include <thread>
+
+#include "native_hal.h"
+
+const byte NATIVE_PORTS = 13;
+const byte NATIVE_ANALOG_PINS = 16;
+const byte MAX_CATCH_UP_PERIODS = 64; // after a long stall, skip the rest
+
+// CLOCK -----------------------------------------------------------------------
+static bool is_clock_virtual = false;
+static unsigned long long virtual_micros = 0;
+static const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+void native_use_virtual_clock(bool is_virtual) {
+  if (is_virtual && !is_clock_virtual) {
+    virtual_micros = native_get_micros(); // time does not jump back
+  }
+  is_clock_virtual = is_virtual;
+}
+
+void native_advance_micros(unsigned long us) { virtual_micros += us; }
+
+void native_set_micros(unsigned long long us) { virtual_micros = us; }
+
+unsigned long long native_get_micros() {
+  if (is_clock_virtual) {
+    return virtual_micros;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start_time;
+  return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+// unsigned long has 64 bits on a 64 bit host, the clock does not overflow:
+unsigned long micros() { return native_get_micros(); }
+
+unsigned long millis() { return native_get_micros() / 1000; }
+
+// TIMER INTERRUPTS ------------------------------------------------------------
+struct Timer_interrupt {
+  Native_interrupt_handler handler;
+  unsigned long period;
+  unsigned long long next_due_time;
+  byte catch_up_count;
+};
+
+static Timer_interrupt timer_interrupts[NATIVE_MAX_TIMER_INTERRUPTS];
+static byte number_of_timer_interrupts = 0;
+static bool is_in_interrupt = false;
+
+void native_attach_timer_interrupt(Native_interrupt_handler handler, unsigned long period_us) {
+  if (period_us == 0) {
+    return;
+  }
+  for (byte i = 0; i < number_of_timer_interrupts; i++) {
+    if (timer_interrupts[i].handler == handler) {
+      timer_interrupts[i].period = period_us;
+      timer_interrupts[i].next_due_time = native_get_micros() + period_us;
+      return;
+    }
+  }
+  if (number_of_timer_interrupts >= NATIVE_MAX_TIMER_INTERRUPTS) {
+    return;
+  }
+  Timer_interrupt &timer = timer_interrupts[number_of_timer_interrupts++];
+  timer.handler = handler;
+  timer.period = period_us;
+  timer.next_due_time = native_get_micros() + period_us;
+}
+
+// Calls the due handlers in the order of their due times:
+void native_run_interrupts() {
+  if (is_in_interrupt) {
+    return;
+  }
+  is_in_interrupt = true;
+  unsigned long long now = native_get_micros();
+
+  for (byte i = 0; i < number_of_timer_interrupts; i++) {
+    timer_interrupts[i].catch_up_count = 0;
+  }
+  for (;;) {
+    Timer_interrupt *due_timer = NULL;
+    for (byte i = 0; i < number_of_timer_interrupts; i++) {
+      Timer_interrupt &timer = timer_interrupts[i];
+      if (timer.next_due_time > now) {
+        continue;
+      }
+      if (timer.catch_up_count >= MAX_CATCH_UP_PERIODS) {
+        timer.next_due_time = now + timer.period;
+        continue;
+      }
+      if (!due_timer || timer.next_due_time < due_timer->next_due_time) {
+        due_timer = &timer;
+      }
+    }
+    if (!due_timer) {
+      break;
+    }
+    due_timer->next_due_time += due_timer->period;
+    due_timer->catch_up_count++;
+    due_timer->handler();
+  }
+  is_in_interrupt = false;
+}
+
+// For idle times only: the periods on the way are not called, every timer
+// keeps its phase.
+void native_skip_to(unsigned long long time) {
+  if (!is_clock_virtual || time <= virtual_micros) {
+    return;
+  }
+  virtual_micros = time;
+  for (byte i = 0; i < number_of_timer_interrupts; i++) {
+    Timer_interrupt &timer = timer_interrupts[i];
+    if (timer.next_due_time <= time) {
+      timer.next_due_time += (time - timer.next_due_time) / timer.period * timer.period + timer.period;
+    }
+  }
+}
+
+unsigned long long native_get_next_interrupt_time() {
+  unsigned long long next_time = ~0ULL;
+  for (byte i = 0; i < number_of_timer_interrupts; i++) {
+    if (timer_interrupts[i].next_due_time < next_time) {
+      next_time = timer_interrupts[i].next_due_time;
+    }
+  }
+  return next_time;
+}
+
+// DELAY -----------------------------------------------------------------------
+// Every interrupt on the way runs at its due time:
+void native_run_until(unsigned long long end_time) {
+  for (;;) {
+    native_run_interrupts();
+    unsigned long long now = native_get_micros();
+    if (now >= end_time) {
+      return;
+    }
+    unsigned long long next_time = native_get_next_interrupt_time();
+    unsigned long long step_end_time = next_time < end_time ? next_time : end_time;
+    if (step_end_time <= now) {
+      step_end_time = now + 1;
+    }
+    if (is_clock_virtual) {
+      virtual_micros = step_end_time;
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(step_end_time - now));
+    }
+  }
+}
+
+void delay(unsigned long ms) { native_run_until(native_get_micros() + 1000ULL * ms); }
+
+void delayMicroseconds(unsigned int us) { native_run_until(native_get_micros() + us); }
+
+// PINS ------------------------------------------------------------------------
+static volatile uint8_t port_output_registers[NATIVE_PORTS];
+static volatile uint8_t port_input_registers[NATIVE_PORTS];
+static volatile uint8_t port_mode_registers[NATIVE_PORTS];
+static int analog_values[NATIVE_ANALOG_PINS];
+static Native_analog_source analog_source = NULL;
+
+uint8_t digitalPinToPort(uint8_t pin) {
+  if (pin >= NUM_DIGITAL_PINS) {
+    return NOT_A_PORT;
+  }
+  return pin / 8 + 1;
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin) { return 1 << (pin % 8); }
+
+volatile uint8_t *portOutputRegister(uint8_t port) { return &port_output_registers[port]; }
+
+volatile uint8_t *portInputRegister(uint8_t port) { return &port_input_registers[port]; }
+
+volatile uint8_t *portModeRegister(uint8_t port) { return &port_mode_registers[port]; }
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PORT) {
+    return;
+  }
+  if (mode == OUTPUT) {
+    port_mode_registers[port] |= digitalPinToBitMask(pin);
+  } else {
+    port_mode_registers[port] &= ~digitalPinToBitMask(pin);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PORT) {
+    return;
+  }
+  if (value) {
+    port_output_registers[port] |= digitalPinToBitMask(pin);
+  } else {
+    port_output_registers[port] &= ~digitalPinToBitMask(pin);
+  }
+}
+
+// Like the PIN register of the ATmega, an output reads back its own level:
+int digitalRead(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PORT) {
+    return LOW;
+  }
+  uint8_t mask = digitalPinToBitMask(pin);
+  if (port_mode_registers[port] & mask) {
+    return port_output_registers[port] & mask ? HIGH : LOW;
+  }
+  return port_input_registers[port] & mask ? HIGH : LOW;
+}
+
+void native_set_digital_input(uint8_t pin, bool state) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PORT) {
+    return;
+  }
+  if (state) {
+    port_input_registers[port] |= digitalPinToBitMask(pin);
+  } else {
+    port_input_registers[port] &= ~digitalPinToBitMask(pin);
+  }
+}
+
+bool native_get_digital_output(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PORT) {
+    return false;
+  }
+  return port_output_registers[port] & digitalPinToBitMask(pin);
+}
+
+static byte get_analog_channel(uint8_t pin) { return (pin >= A0 ? pin - A0 : pin) % NATIVE_ANALOG_PINS; }
+
+int analogRead(uint8_t pin) {
+  if (analog_source) {
+    return constrain(analog_source(pin), 0, 1023);
+  }
+  return analog_values[get_analog_channel(pin)];
+}
+
+void native_set_analog_value(uint8_t pin, int value) {
+  analog_values[get_analog_channel(pin)] = constrain(value, 0, 1023);
+}
+
+void native_set_analog_source(Native_analog_source source) { analog_source = source; }
+
+// STRINGS ---------------------------------------------------------------------
+char *ultoa(unsigned long value, char *buffer, int radix) {
+  char digits[33];
+  byte length = 0;
+  do {
+    byte digit = value % radix;
+    digits[length++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= radix;
+  } while (value);
+  for (byte i = 0; i < length; i++) {
+    buffer[i] = digits[length - 1 - i];
+  }
+  buffer[length] = '\0';
+  return buffer;
+}
+
+char *ltoa(long value, char *buffer, int radix) {
+  if (value < 0 && radix == 10) {
+    buffer[0] = '-';
+    ultoa(-(unsigned long)value, buffer + 1, radix);
+    return buffer;
+  }
+  return ultoa((unsigned long)value, buffer, radix);
+}
+
+char *itoa(int value, char *buffer, int radix) { return ltoa(value, buffer, radix); }
+
+// PRINT -----------------------------------------------------------------------
+size_t Print::write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    write(buffer[i]);
+  }
+  return size;
+}
+
+size_t Print::print(const __FlashStringHelper *text) { return write(reinterpret_cast<const char *>(text)); }
+
+size_t Print::print(const char *text) { return write(text); }
+
+size_t Print::print(char character) { return write((uint8_t)character); }
+
+size_t Print::print(unsigned char value, int base) { return print((unsigned long)value, base); }
+
+size_t Print::print(int value, int base) { return print((long)value, base); }
+
+size_t Print::print(unsigned int value, int base) { return print((unsigned long)value, base); }
+
+size_t Print::print(long value, int base) {
+  char buffer[34];
+  return write(ltoa(value, buffer, base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char buffer[34];
+  return write(ultoa(value, buffer, base));
+}
+
+size_t Print::print(double value, int digits) {
+  char buffer[48];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+  return write(buffer);
+}
+
+size_t Print::println() { return write("\r\n"); }
+
+// SERIAL ----------------------------------------------------------------------
+const int SERIAL_TX_SPACE = 63; // like the transmit buffer of the Arduino core
+
+HardwareSerial Serial;
+HardwareSerial Serial2;
+
+HardwareSerial::HardwareSerial() {
+  _input_head = 0;
+  _input_tail = 0;
+  _output_tail = 0;
+  _output_count = 0;
+  _is_echoed = false;
+}
+
+void HardwareSerial::begin(unsigned long baud) { (void)baud; }
+
+void HardwareSerial::end() {}
+
+int HardwareSerial::available() { return (_input_head + BUFFER_SIZE - _input_tail) % BUFFER_SIZE; }
+
+int HardwareSerial::read() {
+  if (_input_tail == _input_head) {
+    return -1;
+  }
+  uint8_t data = _input[_input_tail];
+  _input_tail = (_input_tail + 1) % BUFFER_SIZE;
+  return data;
+}
+
+int HardwareSerial::peek() {
+  if (_input_tail == _input_head) {
+    return -1;
+  }
+  return _input[_input_tail];
+}
+
+// The line never stalls, bytes nobody takes out are dropped (oldest first):
+size_t HardwareSerial::write(uint8_t data) {
+  if (_is_echoed) {
+    putchar(data);
+    if (data == '\n') {
+      fflush(stdout);
+    }
+    return 1;
+  }
+  _output[(_output_tail + _output_count) % BUFFER_SIZE] = data;
+  if (_output_count == BUFFER_SIZE) {
+    _output_tail = (_output_tail + 1) % BUFFER_SIZE;
+  } else {
+    _output_count++;
+  }
+  return 1;
+}
+
+int HardwareSerial::availableForWrite() { return SERIAL_TX_SPACE; }
+
+void HardwareSerial::inject(const uint8_t *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    size_t next_head = (_input_head + 1) % BUFFER_SIZE;
+    if (next_head == _input_tail) {
+      return; // receive buffer full
+    }
+    _input[_input_head] = data[i];
+    _input_head = next_head;
+  }
+}
+
+void HardwareSerial::inject(const char *text) { inject((const uint8_t *)text, strlen(text)); }
+
+size_t HardwareSerial::take_output(uint8_t *buffer, size_t size) {
+  size_t count = _output_count < size ? _output_count : size;
+  for (size_t i = 0; i < count; i++) {
+    buffer[i] = _output[_output_tail];
+    _output_tail = (_output_tail + 1) % BUFFER_SIZE;
+  }
+  _output_count -= count;
+  return count;
+}
+
+size_t HardwareSerial::get_output_count() { return _output_count; }
+
+void HardwareSerial::set_echo(bool is_echoed) { _is_echoed = is_echoed; }
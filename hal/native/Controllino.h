@@ -0,0 +1,44 @@
+// Pins of the CONTROLLINO MAXI for the host build:
+#ifndef NativeControllino_H_
+#define NativeControllino_H_
+
+#include <Arduino.h>
+
+#define CONTROLLINO_D0 2
+#define CONTROLLINO_D1 3
+#define CONTROLLINO_D2 4
+#define CONTROLLINO_D3 5
+#define CONTROLLINO_D4 6
+#define CONTROLLINO_D5 7
+#define CONTROLLINO_D6 8
+#define CONTROLLINO_D7 9
+#define CONTROLLINO_D8 10
+#define CONTROLLINO_D9 11
+#define CONTROLLINO_D10 12
+#define CONTROLLINO_D11 13
+
+#define CONTROLLINO_R0 22
+#define CONTROLLINO_R1 23
+#define CONTROLLINO_R2 24
+#define CONTROLLINO_R3 25
+#define CONTROLLINO_R4 26
+#define CONTROLLINO_R5 27
+#define CONTROLLINO_R6 28
+#define CONTROLLINO_R7 29
+#define CONTROLLINO_R8 30
+#define CONTROLLINO_R9 31
+
+#define CONTROLLINO_A0 A0
+#define CONTROLLINO_A1 A1
+#define CONTROLLINO_A2 A2
+#define CONTROLLINO_A3 A3
+#define CONTROLLINO_A4 A4
+#define CONTROLLINO_A5 A5
+#define CONTROLLINO_A6 A6
+#define CONTROLLINO_A7 A7
+#define CONTROLLINO_A8 A8
+#define CONTROLLINO_A9 A9
+#define CONTROLLINO_IN0 18
+#define CONTROLLINO_IN1 19
+
+#endif /* NativeControllino_H_ */
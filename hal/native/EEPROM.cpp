@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * EEPROM.cpp (native) *********************************************************
+ *******************************************************************************/
+
+#include "EEPROM.h"
+
+#include <stdio.h>
+
+Native_EEPROM EEPROM;
+
+static const char *get_file_name() {
+  const char *file_name = getenv("NATIVE_EEPROM_FILE");
+  return file_name ? file_name : ".native_eeprom.bin";
+}
+
+void Native_EEPROM::load() {
+  memset(_data, 0xFF, sizeof(_data));
+  FILE *file = fopen(get_file_name(), "rb");
+  if (file) {
+    size_t bytes_read = fread(_data, 1, sizeof(_data), file);
+    (void)bytes_read; // a short file leaves the rest erased
+    fclose(file);
+  }
+  _is_loaded = true;
+}
+
+void Native_EEPROM::store() {
+  FILE *file = fopen(get_file_name(), "wb");
+  if (file) {
+    fwrite(_data, 1, sizeof(_data), file);
+    fclose(file);
+  }
+}
+
+uint8_t Native_EEPROM::read(int address) {
+  if (!_is_loaded) {
+    load();
+  }
+  if (address < 0 || address >= NATIVE_EEPROM_SIZE) {
+    return 0xFF;
+  }
+  return _data[address];
+}
+
+void Native_EEPROM::write(int address, uint8_t value) {
+  if (!_is_loaded) {
+    load();
+  }
+  if (address < 0 || address >= NATIVE_EEPROM_SIZE) {
+    return;
+  }
+  _data[address] = value;
+  store();
+}
+
+void Native_EEPROM::update(int address, uint8_t value) {
+  if (read(address) != value) {
+    write(address, value);
+  }
+}
@@ -0,0 +1,76 @@
+/* *****************************************************************************
+ * EEPROM.h (native) ***********************************************************
+ * *****************************************************************************
+ * EEPROM OF THE HOST BUILD, 4 KB KEPT IN A FILE
+ *
+ * The file is named by the environment variable NATIVE_EEPROM_FILE (default
+ * ".native_eeprom.bin"), it is read on first access and written on every
+ * change. A new EEPROM is erased (0xFF) like a new ATmega2560.
+ * *****************************************************************************
+ */
+
+#ifndef NativeEEPROM_H_
+#define NativeEEPROM_H_
+
+#include <Arduino.h>
+
+const int NATIVE_EEPROM_SIZE = 4096;
+
+class Native_EEPROM {
+
+public:
+  // FUNCTIONS:
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+  uint16_t length() { return NATIVE_EEPROM_SIZE; }
+
+  template <class T> T &get(int address, T &data) {
+    uint8_t *bytes = (uint8_t *)&data;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      bytes[i] = read(address + i);
+    }
+    return data;
+  }
+
+  template <class T> const T &put(int address, const T &data) {
+    const uint8_t *bytes = (const uint8_t *)&data;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      update(address + i, bytes[i]);
+    }
+    return data;
+  }
+
+  // Reads like a byte, writes through update():
+  class Reference {
+  public:
+    Reference(Native_EEPROM &eeprom, int address) : _eeprom(eeprom), _address(address) {}
+    operator uint8_t() const { return _eeprom.read(_address); }
+    Reference &operator=(uint8_t value) {
+      _eeprom.update(_address, value);
+      return *this;
+    }
+
+  private:
+    Native_EEPROM &_eeprom;
+    int _address;
+  };
+
+  Reference operator[](int address) { return Reference(*this, address); }
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void load();
+  void store();
+
+  // VARIABLES:
+  uint8_t _data[NATIVE_EEPROM_SIZE];
+  bool _is_loaded = false;
+};
+
+extern Native_EEPROM EEPROM;
+
+#endif /* NativeEEPROM_H_ */
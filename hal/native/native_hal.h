@@ -0,0 +1,48 @@
+/* *****************************************************************************
+ * native_hal.h ****************************************************************
+ * *****************************************************************************
+ * CONTROL OF THE HOST BUILD [env:native]
+ *
+ * What the hardware does on its own is controlled from here: the clock, the
+ * levels of the input pins, the analog values and the timer interrupts.
+ *
+ * By default the clock follows the wall clock. With a virtual clock, time
+ * only passes by native_advance_micros() (and delay()), a run is repeatable.
+ *
+ * Timer interrupts are called by native_run_interrupts(), once for every
+ * period that has passed. This happens before every call of loop() and
+ * inside delay(). A simulator that knows nothing happens for a while can
+ * jump over that time with native_skip_to(), without the interrupts.
+ * *****************************************************************************
+ */
+
+#ifndef NativeHal_H_
+#define NativeHal_H_
+
+#include <Arduino.h>
+
+typedef void (*Native_interrupt_handler)();
+typedef int (*Native_analog_source)(uint8_t pin);
+
+const byte NATIVE_MAX_TIMER_INTERRUPTS = 8;
+
+// CLOCK -----------------------------------------------------------------------
+void native_use_virtual_clock(bool is_virtual);
+void native_advance_micros(unsigned long us);
+void native_set_micros(unsigned long long us);
+unsigned long long native_get_micros(); // does not overflow
+
+// TIMER INTERRUPTS ------------------------------------------------------------
+void native_attach_timer_interrupt(Native_interrupt_handler handler, unsigned long period_us);
+void native_run_interrupts();
+void native_run_until(unsigned long long time); // like delay(), to a point in time
+unsigned long long native_get_next_interrupt_time();
+void native_skip_to(unsigned long long time); // virtual clock, no interrupts on the way
+
+// PINS ------------------------------------------------------------------------
+void native_set_digital_input(uint8_t pin, bool state);
+bool native_get_digital_output(uint8_t pin);
+void native_set_analog_value(uint8_t pin, int value);
+void native_set_analog_source(Native_analog_source source); // overrides values
+
+#endif /* NativeHal_H_ */
@@ -0,0 +1,22 @@
+/*******************************************************************************
+ * native_main.cpp *************************************************************
+ *******************************************************************************
+ * Runs the firmware like the Arduino core does. A simulator that drives the
+ * firmware itself defines NATIVE_CUSTOM_MAIN and brings its own main().
+ *******************************************************************************/
+
+#ifndef NATIVE_CUSTOM_MAIN
+
+#include <native_hal.h>
+
+int main() {
+  Serial.set_echo(true);
+  setup();
+  for (;;) {
+    native_run_interrupts();
+    loop();
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,9 @@
+// Interrupts never interrupt the loop on the host, a block is always atomic:
+#ifndef NativeAtomic_H_
+#define NativeAtomic_H_
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 0
+#define ATOMIC_BLOCK(type) for (int _atomic_done = 0; !_atomic_done; _atomic_done = 1)
+
+#endif /* NativeAtomic_H_ */
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * firmware_access.cpp *********************************************************
+ *******************************************************************************/
+
+#include "firmware_access.h"
+
+#include <EEPROM_Counter.h>
+#include <Insomnia.h>
+#include <cycle_step.h>
+#include <native_hal.h>
+#include <state_controller.h>
+#include <task_scheduler.h>
+
+extern EEPROM_Counter eeprom_counter;
+extern Task_scheduler task_scheduler;
+extern Cycle_step_engine cycle_steps;
+extern State_controller state_controller;
+extern Step_overlap step_overlap;
+extern Insomnia timeout_long_pause;
+
+// Components of display page 1 (main.cpp):
+const byte NEX_PAGE_1 = 1;
+const byte NEX_PAGE = 0;
+const byte NEX_BUTTON_RESET_MACHINE = 5;
+const byte NEX_BUTTON_MODE = 4;
+const byte NEX_BUTTON_PLAY_PAUSE = 22;
+
+// SETTINGS --------------------------------------------------------------------
+void set_firmware_setting(eeprom_setting setting, long value) { eeprom_counter.set_value(setting, value); }
+
+long get_firmware_setting(eeprom_setting setting) { return eeprom_counter.get_value(setting); }
+
+// DISPLAY ---------------------------------------------------------------------
+void touch_display(byte page, byte component) {
+  const uint8_t frame[] = {0x65, page, component, 0x01, 0xFF, 0xFF, 0xFF};
+  Serial2.inject(frame, sizeof(frame));
+}
+
+void start_auto_mode() {
+  touch_display(NEX_PAGE_1, NEX_PAGE);
+  touch_display(NEX_PAGE_1, NEX_BUTTON_RESET_MACHINE);
+  touch_display(NEX_PAGE_1, NEX_BUTTON_MODE); // step => auto
+  touch_display(NEX_PAGE_1, NEX_BUTTON_PLAY_PAUSE);
+}
+
+// On the host, flash strings are plain strings:
+const char *get_current_step_name() {
+  return reinterpret_cast<const char *>(cycle_steps.get_display_text(state_controller.get_current_step()));
+}
+
+// CLOCK -----------------------------------------------------------------------
+void advance_to_next_tick(unsigned long fixed_step) {
+  unsigned long long now = native_get_micros();
+  if (fixed_step) {
+    native_run_until(now + fixed_step);
+    return;
+  }
+  long time_to_tick = task_scheduler.get_next_due_time() - millis(); // [ms]
+  if (time_to_tick < 1) {
+    time_to_tick = 1; // tick has run, the next one is a millisecond ahead at the earliest
+  }
+  native_run_until(now - now % 1000 + 1000ULL * time_to_tick);
+}
+
+unsigned long long get_idle_deadline() {
+  byte cooldown_step = cycle_steps.get_number_of_steps() - 1;
+  if (!state_controller.machine_is_running() || !cycle_steps.is_started(cooldown_step) ||
+      !step_overlap.is_prepared()) {
+    return 0;
+  }
+  unsigned long time_left = timeout_long_pause.get_remaining_timeout_time(); // [ms]
+  if (time_left == 0) {
+    return 0;
+  }
+  return 1000ULL * (millis() + time_left);
+}
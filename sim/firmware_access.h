@@ -0,0 +1,42 @@
+/* *****************************************************************************
+ * firmware_access.h ***********************************************************
+ * *****************************************************************************
+ * WHAT THE SIMULATORS NEED FROM THE FIRMWARE OF THE HOST BUILD
+ *
+ * Settings in the EEPROM, the display (touch frames on Serial2), the current
+ * step and a clock that jumps from one scheduler tick to the next.
+ * *****************************************************************************
+ */
+
+#ifndef FirmwareAccess_H_
+#define FirmwareAccess_H_
+
+#include <Arduino.h>
+
+// Order of enum eeprom_counter in main.cpp, fixed by the EEPROM layout:
+enum eeprom_setting {
+  eeprom_startfuelldruck,
+  eeprom_shorttime_counter,
+  eeprom_longtime_counter,
+  eeprom_cycles_in_a_row,
+  eeprom_long_cooldown_time,
+  eeprom_strap_eject_feed_time,
+  eeprom_tool_temperature,
+  eeprom_first_step_timeout, // one value per step, 0 = default
+};
+
+void set_firmware_setting(eeprom_setting setting, long value);
+long get_firmware_setting(eeprom_setting setting);
+
+void touch_display(byte page, byte component);
+void start_auto_mode(); // reset, switch to auto mode and start
+const char *get_current_step_name();
+
+// Advances the virtual clock to the next scheduler tick, or by a fixed step:
+void advance_to_next_tick(unsigned long fixed_step = 0); // [us]
+
+// End of the cooldown pause [us] while the firmware only waits for it (last
+// step started, next strap prepared), else 0:
+unsigned long long get_idle_deadline();
+
+#endif /* FirmwareAccess_H_ */
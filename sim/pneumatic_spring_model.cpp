@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * pneumatic_spring_model.cpp **************************************************
+ *******************************************************************************/
+
+#include "pneumatic_spring_model.h"
+
+#include <math.h>
+
+const float ATMOSPHERE = 1.013; // [bar] absolute
+const float MAX_SUBSTEP = 0.0005; // [s] keeps the integration stable
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Pneumatic_spring_model::Pneumatic_spring_model() {
+  parameters.supply_pressure = 6.0;
+  parameters.volume = 1.5;
+  parameters.zuluft_conductance = 0.5;
+  parameters.abluft_conductance = 1.0;
+  parameters.leakage_conductance = 0.002;
+  parameters.critical_pressure_ratio = 0.3;
+  parameters.sensor_time_constant = 0.02;
+  parameters.force_per_bar = 1472.6; // see pressure_filter.cpp
+  vent();
+}
+
+void Pneumatic_spring_model::vent() {
+  _pressure = ATMOSPHERE;
+  _sensed_pressure = ATMOSPHERE;
+}
+
+// FLOW (ISO 6358) -------------------------------------------------------------
+// Returns the flow [l/s] at normal conditions, negative if it flows backwards:
+float Pneumatic_spring_model::get_flow(float conductance, float upstream_pressure, float downstream_pressure) {
+  if (upstream_pressure < downstream_pressure) {
+    return -get_flow(conductance, downstream_pressure, upstream_pressure);
+  }
+  float b = parameters.critical_pressure_ratio;
+  float ratio = downstream_pressure / upstream_pressure;
+  if (ratio <= b) {
+    return conductance * upstream_pressure; // choked
+  }
+  float subsonic = (ratio - b) / (1 - b);
+  return conductance * upstream_pressure * sqrtf(1 - subsonic * subsonic);
+}
+
+// SIMULATE --------------------------------------------------------------------
+void Pneumatic_spring_model::step(float dt, bool is_zuluft_open, bool is_abluft_open) {
+  float supply = parameters.supply_pressure + ATMOSPHERE;
+
+  while (dt > 0) {
+    float substep = dt < MAX_SUBSTEP ? dt : MAX_SUBSTEP;
+    dt -= substep;
+
+    float flow = -get_flow(parameters.leakage_conductance, _pressure, ATMOSPHERE);
+    if (is_zuluft_open) {
+      flow += get_flow(parameters.zuluft_conductance, supply, _pressure);
+    }
+    if (is_abluft_open) {
+      flow -= get_flow(parameters.abluft_conductance, _pressure, ATMOSPHERE);
+    }
+    // Isothermal: the pressure changes with the amount of air in the volume:
+    _pressure += flow * ATMOSPHERE / parameters.volume * substep;
+    if (_pressure < ATMOSPHERE) {
+      _pressure = ATMOSPHERE;
+    }
+    _sensed_pressure += (_pressure - _sensed_pressure) * substep / (parameters.sensor_time_constant + substep);
+  }
+}
+
+// GETTER ----------------------------------------------------------------------
+float Pneumatic_spring_model::get_pressure() { return _pressure - ATMOSPHERE; }
+
+float Pneumatic_spring_model::get_sensed_pressure() { return _sensed_pressure - ATMOSPHERE; }
+
+float Pneumatic_spring_model::get_force() { return get_pressure() * parameters.force_per_bar; }
@@ -0,0 +1,53 @@
+/* *****************************************************************************
+ * pneumatic_spring_model.h ****************************************************
+ * *****************************************************************************
+ * MODEL OF THE 800mm CYLINDER (PNEUMATIC SPRING) AND ITS PRESSURE SENSOR
+ *
+ * One chamber of constant volume, filled by the zuluft valve from the supply,
+ * vented by the abluft valve (open if the output is off) and a leakage to
+ * atmosphere. The flow through each restriction follows ISO 6358: a sonic
+ * conductance and a critical pressure ratio. The temperature is constant.
+ *
+ * The pressure sensor follows the chamber pressure with a first order lag.
+ * *****************************************************************************
+ */
+
+#ifndef PneumaticSpringModel_H_
+#define PneumaticSpringModel_H_
+
+struct Pneumatic_spring_parameters {
+  float supply_pressure; // [bar] gauge
+  float volume; // [l] chamber and hose
+  float zuluft_conductance; // [l/(s*bar)] sonic conductance of the supply path
+  float abluft_conductance; // [l/(s*bar)] sonic conductance of the exhaust path
+  float leakage_conductance; // [l/(s*bar)]
+  float critical_pressure_ratio;
+  float sensor_time_constant; // [s]
+  float force_per_bar; // [N/bar]
+};
+
+class Pneumatic_spring_model {
+
+public:
+  // FUNCTIONS:
+  Pneumatic_spring_model();
+
+  void step(float dt, bool is_zuluft_open, bool is_abluft_open); // [s]
+  void vent();
+
+  float get_pressure(); // [bar] gauge
+  float get_sensed_pressure(); // [bar] gauge, as seen by the sensor
+  float get_force(); // [N]
+
+  // VARIABLES:
+  Pneumatic_spring_parameters parameters;
+
+private:
+  // FUNCTIONS:
+  float get_flow(float conductance, float upstream_pressure, float downstream_pressure);
+
+  // VARIABLES:
+  float _pressure; // [bar] absolute
+  float _sensed_pressure; // [bar] absolute
+};
+#endif /* PneumaticSpringModel_H_ */
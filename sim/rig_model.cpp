@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * rig_model.cpp ***************************************************************
+ *******************************************************************************/
+
+#include "rig_model.h"
+
+#include <Controllino.h>
+#include <native_hal.h>
+
+// WIRING (main.cpp) -----------------------------------------------------------
+const byte DRUCKSENSOR = CONTROLLINO_A7;
+const byte BANDSENSOR_OBEN = CONTROLLINO_A0;
+const byte BANDSENSOR_UNTEN = CONTROLLINO_A1;
+const byte TASTER_STARTPOSITION = CONTROLLINO_A2;
+const byte TASTER_ENDPOSITION = CONTROLLINO_A3;
+const byte ZYL_HAUPTLUFT = CONTROLLINO_D7;
+const byte ZYL_800_ABLUFT = CONTROLLINO_D1;
+const byte ZYL_800_ZULUFT = CONTROLLINO_D0;
+const byte ZYL_SPANNTASTE = CONTROLLINO_D3;
+
+const float ADC_PER_BAR = 27.778; // see pressure_filter.cpp
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Rig_model::Rig_model() {
+  parameters.tensioning_time = 1.2;
+  parameters.return_time = 0.8;
+  _tool_position = 0;
+}
+
+void Rig_model::begin() {
+  native_set_digital_input(BANDSENSOR_OBEN, true);
+  native_set_digital_input(BANDSENSOR_UNTEN, true);
+  write_inputs();
+}
+
+// SIMULATE ONE PERIOD ---------------------------------------------------------
+void Rig_model::step(unsigned long period) {
+  float dt = period / 1e6;
+  bool has_supply = native_get_digital_output(ZYL_HAUPTLUFT);
+  bool is_zuluft_open = has_supply && native_get_digital_output(ZYL_800_ZULUFT);
+  bool is_abluft_closed = native_get_digital_output(ZYL_800_ABLUFT);
+
+  pneumatic_spring.step(dt, is_zuluft_open, !is_abluft_closed);
+
+  // Tensioning tool:
+  if (native_get_digital_output(ZYL_SPANNTASTE) && has_supply) {
+    _tool_position += dt / parameters.tensioning_time;
+  } else if (is_zuluft_open && !is_abluft_closed) {
+    _tool_position -= dt / parameters.return_time;
+  }
+  _tool_position = constrain(_tool_position, 0.0f, 1.0f);
+
+  write_inputs();
+}
+
+void Rig_model::write_inputs() {
+  native_set_analog_value(DRUCKSENSOR, pneumatic_spring.get_sensed_pressure() * ADC_PER_BAR + 0.5);
+  native_set_digital_input(TASTER_STARTPOSITION, _tool_position <= 0);
+  native_set_digital_input(TASTER_ENDPOSITION, _tool_position >= 1);
+}
+
+// GETTER ----------------------------------------------------------------------
+float Rig_model::get_tool_position() { return _tool_position; }
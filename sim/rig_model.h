@@ -0,0 +1,52 @@
+/* *****************************************************************************
+ * rig_model.h *****************************************************************
+ * *****************************************************************************
+ * SIMULATED MACHINE AROUND THE FIRMWARE OF THE HOST BUILD
+ *
+ * Reads the valve outputs of the firmware and drives its inputs:
+ * - strap sensors: strap always present
+ * - tensioning tool: the spanntaste moves the tool towards the endposition
+ *   switch, the 800mm cylinder ("move") pulls it back to the startposition
+ * - 800mm cylinder: see pneumatic_spring_model.h, the sensed pressure is fed
+ *   to the pressure sensor input
+ *
+ * Wiring as in main.cpp. step() is called at a fixed period, the model is
+ * deterministic and does not depend on how the clock advances.
+ * *****************************************************************************
+ */
+
+#ifndef RigModel_H_
+#define RigModel_H_
+
+#include <Arduino.h>
+
+#include "pneumatic_spring_model.h"
+
+struct Rig_parameters {
+  float tensioning_time; // [s] tool from start- to endposition
+  float return_time; // [s] tool from end- to startposition
+};
+
+class Rig_model {
+
+public:
+  // FUNCTIONS:
+  Rig_model();
+
+  void begin();
+  void step(unsigned long period); // [us]
+
+  float get_tool_position(); // 0 = startposition, 1 = endposition
+
+  // VARIABLES:
+  Rig_parameters parameters;
+  Pneumatic_spring_model pneumatic_spring;
+
+private:
+  // FUNCTIONS:
+  void write_inputs();
+
+  // VARIABLES:
+  float _tool_position;
+};
+#endif /* RigModel_H_ */
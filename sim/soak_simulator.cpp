@@ -0,0 +1,206 @@
+/* *****************************************************************************
+ * soak_simulator.cpp **********************************************************
+ * *****************************************************************************
+ * ENDURANCE RUN OF THE FIRMWARE AGAINST A VIRTUAL CLOCK [env:native_sim]
+ *
+ * Runs setup() and loop() of the unmodified firmware with the rig model,
+ * starts the machine in auto mode through the display (touch frames on
+ * Serial2) and counts the finished cycles.
+ *
+ * The firmware looks at the clock only when the task scheduler runs a tick
+ * (or in an interrupt). Between two ticks the clock jumps straight to the
+ * next due tick, all interrupts on the way run at their due time. With
+ * -s <us> the clock advances in fixed steps instead, like a loop that polls
+ * all the time. Both runs produce the same valve events, compare the
+ * signatures.
+ *
+ * During the cooldown pause the firmware only waits. Once the next strap is
+ * prepared and no valve has switched for a second, the clock jumps in steps
+ * of 100 ms, one loop per step and without interrupts, until shortly before
+ * the end of the pause (get_idle_deadline()). -a runs every tick instead,
+ * the valve signature is the same.
+ *
+ * Usage: soak_simulator [-n cycles] [-c cooldown s] [-f startfuelldruck N]
+ *                       [-s fixed step us] [-a (all ticks)]
+ *                       [-t (trace valve events)]
+ * *****************************************************************************
+ */
+
+#include <chrono> // before Arduino.h, which defines min() and max()
+#include <stdio.h>
+#include <unistd.h>
+
+#include <Controllino.h>
+#include <native_hal.h>
+
+#include "firmware_access.h"
+#include "rig_model.h"
+
+const unsigned long RIG_MODEL_PERIOD = 100; // [us]
+const unsigned long long MAX_CYCLE_TIME = 120000000ULL; // [us] plus cooldown
+const unsigned long long IDLE_SETTLE_TIME = 1000000; // [us] without valve events
+const unsigned long long IDLE_STEP = 100000; // [us]
+const unsigned long long IDLE_MARGIN = 2000; // [us] ticks before the end of the pause
+
+// VALVE TRACE -----------------------------------------------------------------
+struct Traced_valve {
+  byte pin;
+  const char *name;
+};
+
+const Traced_valve traced_valves[] = {
+    {CONTROLLINO_D7, "hauptluft"},       {CONTROLLINO_D1, "800_abluft"},     {CONTROLLINO_D0, "800_zuluft"},
+    {CONTROLLINO_D2, "startklemme"},     {CONTROLLINO_D5, "wippenhebel"},    {CONTROLLINO_D3, "spanntaste"},
+    {CONTROLLINO_D4, "schweisstaste"},   {CONTROLLINO_D9, "niederhalter"},   {CONTROLLINO_D6, "messer"},
+    {CONTROLLINO_D8, "klemmrad"},        {CONTROLLINO_R5, "foerdermotor"},   {CONTROLLINO_D10, "signal_green"},
+    {CONTROLLINO_D11, "signal_red"},
+};
+const byte NUMBER_OF_TRACED_VALVES = sizeof(traced_valves) / sizeof(Traced_valve);
+
+static Rig_model rig_model;
+static bool valve_states[NUMBER_OF_TRACED_VALVES];
+static unsigned long long valve_event_count = 0;
+static unsigned long long valve_signature = 0xcbf29ce484222325ULL; // FNV-1a
+static bool is_traced = false;
+static unsigned long long last_valve_event_time = 0; // [us]
+static unsigned long long skipped_time = 0; // [us]
+
+static void add_to_signature(unsigned long long value) {
+  for (byte i = 0; i < 8; i++) {
+    valve_signature ^= (value >> (8 * i)) & 0xFF;
+    valve_signature *= 0x100000001b3ULL;
+  }
+}
+
+// Runs every RIG_MODEL_PERIOD, records the valve changes and moves the rig:
+static void observe_rig() {
+  unsigned long long now = native_get_micros();
+  for (byte i = 0; i < NUMBER_OF_TRACED_VALVES; i++) {
+    bool state = native_get_digital_output(traced_valves[i].pin);
+    if (state == valve_states[i]) {
+      continue;
+    }
+    valve_states[i] = state;
+    valve_event_count++;
+    last_valve_event_time = now;
+    add_to_signature(now);
+    add_to_signature(i << 1 | state);
+    if (is_traced) {
+      printf("%12.1f ms %-14s %d\n", now / 1000.0, traced_valves[i].name, state);
+    }
+  }
+  rig_model.step(RIG_MODEL_PERIOD);
+
+  uint8_t display_output[64];
+  while (Serial2.take_output(display_output, sizeof(display_output))) {
+    // nobody reads the display
+  }
+}
+
+// IDLE TIME -------------------------------------------------------------------
+// Returns false if the firmware or the rig has something to do:
+static bool skip_idle_time() {
+  unsigned long long now = native_get_micros();
+  unsigned long long deadline = get_idle_deadline();
+  if (!deadline || now - last_valve_event_time < IDLE_SETTLE_TIME) {
+    return false;
+  }
+  unsigned long long next_time = now - now % 1000 + IDLE_STEP;
+  if (next_time + IDLE_MARGIN > deadline) {
+    return false;
+  }
+  skipped_time += next_time - now;
+  native_skip_to(next_time);
+  return true;
+}
+
+// SIMULATION ------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+  long number_of_cycles = 100;
+  long cooldown_time = 60; // [s]
+  long startfuelldruck = 3000; // [N]
+  unsigned long fixed_step = 0; // [us], 0 = jump to the next tick
+  bool skips_idle_time = true;
+
+  int option;
+  while ((option = getopt(argc, argv, "n:c:f:s:at")) != -1) {
+    switch (option) {
+    case 'n':
+      number_of_cycles = atol(optarg);
+      break;
+    case 'c':
+      cooldown_time = atol(optarg);
+      break;
+    case 'f':
+      startfuelldruck = atol(optarg);
+      break;
+    case 's':
+      fixed_step = atol(optarg);
+      break;
+    case 'a':
+      skips_idle_time = false;
+      break;
+    case 't':
+      is_traced = true;
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-n cycles] [-c cooldown s] [-f startfuelldruck N] [-s step us] [-a] [-t]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  setenv("NATIVE_EEPROM_FILE", ".native_sim_eeprom.bin", 0);
+  native_use_virtual_clock(true);
+  native_set_micros(0);
+  rig_model.begin();
+
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  setup();
+
+  set_firmware_setting(eeprom_startfuelldruck, startfuelldruck);
+  set_firmware_setting(eeprom_cycles_in_a_row, 1);
+  set_firmware_setting(eeprom_long_cooldown_time, cooldown_time);
+  set_firmware_setting(eeprom_strap_eject_feed_time, 500);
+  long first_count = get_firmware_setting(eeprom_longtime_counter);
+
+  native_attach_timer_interrupt(observe_rig, RIG_MODEL_PERIOD);
+  start_auto_mode();
+
+  long cycle_count = 0;
+  unsigned long long cycle_start_time = native_get_micros();
+  unsigned long long loop_count = 0;
+  bool is_stalled = false;
+
+  while (cycle_count < number_of_cycles) {
+    loop();
+    loop_count++;
+    if (!(skips_idle_time && !fixed_step && skip_idle_time())) {
+      advance_to_next_tick(fixed_step);
+    }
+
+    long count = get_firmware_setting(eeprom_longtime_counter) - first_count;
+    if (count != cycle_count) {
+      cycle_count = count;
+      cycle_start_time = native_get_micros();
+    }
+    if (native_get_micros() - cycle_start_time > MAX_CYCLE_TIME + 1000000ULL * cooldown_time) {
+      is_stalled = true;
+      break;
+    }
+  }
+
+  double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  double simulated_time = native_get_micros() / 1e6;
+
+  printf("cycles:            %ld%s\n", cycle_count, is_stalled ? " (STALLED)" : "");
+  printf("simulated time:    %.1f s\n", simulated_time);
+  printf("wall time:         %.3f s\n", wall_time);
+  printf("cycles per second: %.1f (wall clock)\n", cycle_count / wall_time);
+  printf("speed:             %.0f x real time\n", simulated_time / wall_time);
+  printf("loops:             %llu\n", loop_count);
+  printf("idle time skipped: %.1f s\n", skipped_time / 1e6);
+  printf("valve events:      %llu\n", valve_event_count);
+  printf("valve signature:   %016llx\n", valve_signature);
+  return is_stalled ? 1 : 0;
+}
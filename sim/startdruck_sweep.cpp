@@ -0,0 +1,234 @@
+/* *****************************************************************************
+ * startdruck_sweep.cpp ********************************************************
+ * *****************************************************************************
+ * OFFLINE TUNING OF THE STEP "STARTDRUCK" [env:native_sweep]
+ *
+ * Runs the firmware with the rig model until the step startdruck has
+ * completed, once for every combination of fill time, wait time and
+ * confirmations of the fixed pulses (see startdruck_parameters.h). With -a,
+ * the adaptive pulses are run instead, the lists of -w and -c are the settle
+ * times and the adaptive confirmations.
+ *
+ * Every combination starts from a fresh firmware in its own process and runs
+ * the number of cycles given by -r (the fill controller learns from one
+ * cycle to the next). Reports the last cycle of every combination:
+ * - reach: time until the cylinder force first reaches the target band,
+ *   which is the target less the minimum inflation
+ * - done: time until the step has completed
+ * - overshoot: highest force during the step minus the target
+ * - final: force at completion
+ * - pulses: number of fill pulses
+ *
+ * Usage: startdruck_sweep [-f startfuelldruck N] [-p fill times ms]
+ *                         [-w wait times ms] [-c confirmations]
+ *                         [-a (adaptive)] [-r cycles]
+ *                         [-v volume l] [-z zuluft conductance l/(s*bar)]
+ *                         [-l leakage conductance] [-g sensor lag s]
+ * Lists are comma separated, e.g. -p 60,90,120
+ * *****************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <Controllino.h>
+#include <native_hal.h>
+#include <startdruck_parameters.h>
+
+#include "firmware_access.h"
+#include "rig_model.h"
+
+const unsigned long RIG_MODEL_PERIOD = 100; // [us]
+const unsigned long long MAX_STEP_TIME = 60000000ULL; // [us]
+const byte MAX_LIST_LENGTH = 16;
+
+struct Value_list {
+  long values[MAX_LIST_LENGTH];
+  byte length;
+};
+
+static Rig_model rig_model;
+static long target_force;
+static long number_of_cycles = 1;
+static bool is_in_startdruck = false;
+static unsigned long long reach_time = 0; // [us]
+static float max_force = 0;
+static unsigned int pulse_count = 0;
+static bool was_zuluft_open = false;
+
+// Runs every RIG_MODEL_PERIOD:
+static void observe_rig() {
+  rig_model.step(RIG_MODEL_PERIOD);
+  if (!is_in_startdruck) {
+    return;
+  }
+  float force = rig_model.pneumatic_spring.get_force();
+  if (force > max_force) {
+    max_force = force;
+  }
+  if (!reach_time && force + startdruck_parameters.minimum_inflation > target_force) {
+    reach_time = native_get_micros();
+  }
+  bool is_zuluft_open = native_get_digital_output(CONTROLLINO_D0);
+  if (is_zuluft_open && !was_zuluft_open) {
+    pulse_count++;
+  }
+  was_zuluft_open = is_zuluft_open;
+
+  uint8_t display_output[64];
+  while (Serial2.take_output(display_output, sizeof(display_output))) {
+    // nobody reads the display
+  }
+}
+
+// ONE RUN (CHILD PROCESS) -----------------------------------------------------
+static void run_startdruck() {
+  native_use_virtual_clock(true);
+  native_set_micros(0);
+  rig_model.begin();
+  setup();
+
+  set_firmware_setting(eeprom_startfuelldruck, target_force);
+  set_firmware_setting(eeprom_cycles_in_a_row, 1);
+  set_firmware_setting(eeprom_long_cooldown_time, 0);
+  set_firmware_setting(eeprom_strap_eject_feed_time, 500);
+
+  native_attach_timer_interrupt(observe_rig, RIG_MODEL_PERIOD);
+  start_auto_mode();
+
+  unsigned long long start_time = 0;
+  long completed_count = 0;
+  bool is_timed_out = false;
+  while (completed_count < number_of_cycles) {
+    loop();
+    advance_to_next_tick();
+    bool is_startdruck = strcmp(get_current_step_name(), "STARTDRUCK") == 0;
+    if (is_startdruck && !is_in_startdruck) {
+      start_time = native_get_micros();
+      reach_time = 0;
+      max_force = 0;
+      pulse_count = 0;
+    }
+    if (is_in_startdruck && !is_startdruck) {
+      completed_count++;
+    }
+    is_in_startdruck = is_startdruck;
+    if (is_in_startdruck && native_get_micros() - start_time > MAX_STEP_TIME) {
+      is_timed_out = true;
+      break;
+    }
+  }
+  unsigned long long end_time = native_get_micros();
+
+  const Startdruck_parameters &parameters = startdruck_parameters;
+  if (parameters.is_adaptive) {
+    printf("%5s %5u %5u", "-", parameters.settle_time, parameters.adaptive_confirmations);
+  } else {
+    printf("%5u %5u %5u", parameters.fill_time, parameters.wait_time, parameters.confirmations);
+  }
+  if (reach_time) {
+    printf(" %8llu", (reach_time - start_time) / 1000);
+  } else {
+    printf(" %8s", "-");
+  }
+  if (!is_timed_out) {
+    printf(" %8llu", (end_time - start_time) / 1000);
+  } else {
+    printf(" %8s", "timeout");
+  }
+  printf(" %9.0f %7.0f %6u\n", max_force - target_force, rig_model.pneumatic_spring.get_force(), pulse_count);
+  fflush(stdout);
+}
+
+// OPTIONS ---------------------------------------------------------------------
+static void parse_list(const char *text, Value_list &list) {
+  list.length = 0;
+  while (*text && list.length < MAX_LIST_LENGTH) {
+    char *end;
+    list.values[list.length++] = strtol(text, &end, 10);
+    text = *end == ',' ? end + 1 : end;
+    if (end == text && *end != '\0') {
+      break; // not a number
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Value_list fill_times = {{startdruck_parameters.fill_time}, 1};
+  Value_list wait_times = {{startdruck_parameters.wait_time}, 1};
+  Value_list confirmations = {{startdruck_parameters.confirmations}, 1};
+  target_force = 3000;
+  startdruck_parameters.is_adaptive = false;
+
+  int option;
+  while ((option = getopt(argc, argv, "f:p:w:c:ar:v:z:l:g:")) != -1) {
+    switch (option) {
+    case 'f':
+      target_force = atol(optarg);
+      break;
+    case 'p':
+      parse_list(optarg, fill_times);
+      break;
+    case 'w':
+      parse_list(optarg, wait_times);
+      break;
+    case 'c':
+      parse_list(optarg, confirmations);
+      break;
+    case 'a':
+      startdruck_parameters.is_adaptive = true;
+      wait_times.values[0] = startdruck_parameters.settle_time;
+      confirmations.values[0] = startdruck_parameters.adaptive_confirmations;
+      break;
+    case 'r':
+      number_of_cycles = atol(optarg);
+      break;
+    case 'v':
+      rig_model.pneumatic_spring.parameters.volume = atof(optarg);
+      break;
+    case 'z':
+      rig_model.pneumatic_spring.parameters.zuluft_conductance = atof(optarg);
+      break;
+    case 'l':
+      rig_model.pneumatic_spring.parameters.leakage_conductance = atof(optarg);
+      break;
+    case 'g':
+      rig_model.pneumatic_spring.parameters.sensor_time_constant = atof(optarg);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-f N] [-p ms,..] [-w ms,..] [-c n,..] [-a] [-r n] [-v l] [-z C] [-l C] [-g s]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  setenv("NATIVE_EEPROM_FILE", ".native_sim_eeprom.bin", 0);
+
+  printf("target %ld N, %s pulses, cycle %ld\n", target_force, startdruck_parameters.is_adaptive ? "adaptive" : "fixed",
+         number_of_cycles);
+  printf(" fill  wait  conf reach[ms] done[ms] overshoot final[N] pulses\n");
+  fflush(stdout);
+
+  for (byte p = 0; p < fill_times.length; p++) {
+    for (byte w = 0; w < wait_times.length; w++) {
+      for (byte c = 0; c < confirmations.length; c++) {
+        startdruck_parameters.fill_time = fill_times.values[p];
+        if (startdruck_parameters.is_adaptive) {
+          startdruck_parameters.settle_time = wait_times.values[w];
+          startdruck_parameters.adaptive_confirmations = confirmations.values[c];
+        } else {
+          startdruck_parameters.wait_time = wait_times.values[w];
+          startdruck_parameters.confirmations = confirmations.values[c];
+        }
+        pid_t child = fork();
+        if (child == 0) {
+          run_startdruck();
+          _exit(0);
+        }
+        waitpid(child, NULL, 0);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * command_queue.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "command_queue.h"
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Command_queue::Command_queue() {
+  _head = 0;
+  _tail = 0;
+  _coalesced_count = 0;
+  _dropped_count = 0;
+}
+
+// POST ------------------------------------------------------------------------
+bool Command_queue::post(byte type, byte argument, bool state) {
+  byte next_head = (_head + 1) & (COMMAND_QUEUE_SIZE - 1);
+  if (next_head == _tail) {
+    _dropped_count++;
+    return false;
+  }
+  _commands[_head].type = type;
+  _commands[_head].argument = argument;
+  _commands[_head].state = state;
+  _head = next_head;
+  return true;
+}
+
+// Coalesce with the latest pending command only, the order of different
+// commands (e.g. push and pop of a button) must not change:
+bool Command_queue::post_state(byte type, byte argument, bool state) {
+  if (is_latest_command(type, argument, state)) {
+    _coalesced_count++;
+    return true;
+  }
+  return post(type, argument, state);
+}
+
+bool Command_queue::is_latest_command(byte type, byte argument, bool state) {
+  if (_tail == _head) {
+    return false;
+  }
+  Queued_command &latest = _commands[(_head - 1) & (COMMAND_QUEUE_SIZE - 1)];
+  return latest.type == type && latest.argument == argument && latest.state == state;
+}
+
+// READ ------------------------------------------------------------------------
+bool Command_queue::read(Queued_command &command) {
+  if (_tail == _head) {
+    return false;
+  }
+  command = _commands[_tail];
+  _tail = (_tail + 1) & (COMMAND_QUEUE_SIZE - 1);
+  return true;
+}
+
+// STATISTICS ------------------------------------------------------------------
+unsigned int Command_queue::get_coalesced_count() { return _coalesced_count; }
+
+unsigned int Command_queue::get_dropped_count() { return _dropped_count; }
@@ -0,0 +1,60 @@
+/* *****************************************************************************
+ * command_queue.h *************************************************************
+ * *****************************************************************************
+ * DEFERRED COMMANDS FROM THE TOUCH CALLBACKS TO THE SEQUENCER
+ *
+ * Touch callbacks post typed commands instead of changing the machine state
+ * themselves. The sequencer executes all posted commands at one defined point
+ * of the scan, so the steps see a consistent state for the whole scan.
+ *
+ * Commands with an effect on every call (toggles, step moves, increments) are
+ * posted with post() and always queued. A command that sets a state is posted
+ * with post_state(): if it equals the latest command still waiting in the
+ * queue, the repeat changes nothing and is coalesced with it. If the queue is
+ * full, the command is dropped.
+ * *****************************************************************************
+ */
+
+#ifndef CommandQueue_H_
+#define CommandQueue_H_
+
+#include <Arduino.h>
+
+#ifndef COMMAND_QUEUE_SIZE
+#define COMMAND_QUEUE_SIZE 8 // power of two, one entry is kept free
+#endif
+
+struct Queued_command {
+  byte type;
+  byte argument;
+  bool state;
+};
+
+class Command_queue {
+
+public:
+  // FUNCTIONS:
+  Command_queue();
+
+  bool post(byte type, byte argument = 0, bool state = false);
+  bool post_state(byte type, byte argument, bool state); // coalesced with an equal latest command
+  bool read(Queued_command &command);
+
+  unsigned int get_coalesced_count();
+  unsigned int get_dropped_count();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  bool is_latest_command(byte type, byte argument, bool state);
+
+  // VARIABLES:
+  Queued_command _commands[COMMAND_QUEUE_SIZE];
+  byte _head;
+  byte _tail;
+  unsigned int _coalesced_count;
+  unsigned int _dropped_count;
+};
+#endif /* CommandQueue_H_ */
@@ -1,35 +1,288 @@
 #include "cycle_step.h"
-#include <ArduinoSTL.h>
 
-Cycle_step::Cycle_step() { //
-  object_count++;
+Cycle_step_engine::Cycle_step_engine() {
+  _number_of_steps = 0;
+  _running_step = 0;
 }
 
-void Cycle_step::do_stuff() {
-  if (!_innit_completed) {
-    do_initial_stuff();
-    _innit_completed = true;
+void Cycle_step_engine::setup(const Cycle_step *table, byte number_of_steps) {
+  _table = table;
+  _number_of_steps = min(number_of_steps, (byte)MAX_CYCLE_STEPS);
+  for (byte i = 0; i < _number_of_steps; i++) {
+    reset_flags(i);
+  }
+}
+
+void Cycle_step_engine::read_step(byte step, Cycle_step &entry) { //
+  memcpy_P(&entry, &_table[step], sizeof(Cycle_step));
+}
+
+void Cycle_step_engine::do_stuff(byte step) {
+  Cycle_step entry;
+  read_step(step, entry);
+  byte calling_step = _running_step;
+  _running_step = step;
+  if (!_innit_completed[step]) {
+    _profiler.step_entered(step);
+    entry.do_initial_stuff();
+    _innit_completed[step] = true;
   } else {
-    do_loop_stuff();
+    entry.do_loop_stuff();
   }
+  _running_step = calling_step;
 }
 
-void Cycle_step::reset_flags() {
-  _innit_completed = false;
-  _loop_completed = false;
+void Cycle_step_engine::reset_flags(byte step) {
+  _innit_completed[step] = false;
+  _loop_completed[step] = false;
 }
 
-void Cycle_step::set_loop_completed() { //
-  _loop_completed = true;
+void Cycle_step_engine::set_loop_completed() { //
+  _loop_completed[_running_step] = true;
 }
 
 // This is a "one time flag", state will be reseted after fist inquiry:
-bool Cycle_step::is_completed() {
-  if (_loop_completed) {
-    _loop_completed = false;
-    _innit_completed = false;
+bool Cycle_step_engine::is_completed(byte step) {
+  if (_loop_completed[step]) {
+    _profiler.step_completed(step);
+    _loop_completed[step] = false;
+    _innit_completed[step] = false;
     return true;
   } else {
     return false;
   }
 }
+
+bool Cycle_step_engine::is_started(byte step) { return _innit_completed[step]; }
+
+const __FlashStringHelper *Cycle_step_engine::get_display_text(byte step) {
+  Cycle_step entry;
+  read_step(step, entry);
+  return entry.get_display_text();
+}
+
+byte Cycle_step_engine::get_number_of_steps() { return _number_of_steps; }
+
+Step_profiler &Cycle_step_engine::get_profiler() { return _profiler; }
+
+// STEP OVERLAP ----------------------------------------------------------------
+
+Step_overlap::Step_overlap(Cycle_step_engine &engine) : _engine(engine) {
+  _resources = NULL;
+  _number_of_steps = 0;
+  _first_step = 0;
+  _completed_steps = 0;
+  _is_step_started = false;
+  _is_active = false;
+}
+
+void Step_overlap::setup(const Step_resources *resources, byte first_step, byte number_of_steps) {
+  _resources = resources;
+  _first_step = first_step;
+  _number_of_steps = number_of_steps;
+}
+
+Step_resources Step_overlap::get_resources(byte step) { //
+  return pgm_read_word(&_resources[step]);
+}
+
+void Step_overlap::run(byte holding_step) {
+  if (_completed_steps >= _number_of_steps) {
+    return;
+  }
+  byte step = _first_step + _completed_steps;
+  if (!_is_step_started) {
+    if (get_resources(step) & get_resources(holding_step)) {
+      return; // interlocked, the step waits for the sequence
+    }
+    _is_step_started = true;
+    _is_active = true;
+  }
+  _engine.do_stuff(step);
+  if (_engine.is_completed(step)) {
+    _completed_steps++;
+    _is_step_started = false;
+  }
+}
+
+byte Step_overlap::finish() {
+  byte next_step = _first_step + _completed_steps;
+  _completed_steps = 0;
+  _is_step_started = false;
+  _is_active = false;
+  return next_step;
+}
+
+void Step_overlap::cancel() {
+  for (byte i = 0; i < _number_of_steps; i++) {
+    _engine.reset_flags(_first_step + i);
+  }
+  finish();
+}
+
+bool Step_overlap::is_active() { return _is_active; }
+
+bool Step_overlap::is_prepared() { return _completed_steps >= _number_of_steps; }
+
+byte Step_overlap::get_first_step() { return _first_step; }
+
+byte Step_overlap::get_number_of_completed_steps() { return _completed_steps; }
+
+// STEP GRAPH ------------------------------------------------------------------
+
+Step_graph::Step_graph(Cycle_step_engine &engine) : _engine(engine) {
+  _resources = NULL;
+  _prerequisites = NULL;
+  _running_steps = 0;
+  _completed_steps = 0;
+  _owned_resources = 0;
+  _is_active = false;
+  _cycle_start_time = 0;
+  _last_cycle_time = 0;
+}
+
+void Step_graph::setup(const Step_resources *resources, const Step_set *prerequisites) {
+  _resources = resources;
+  _prerequisites = prerequisites;
+}
+
+Step_set Step_graph::get_all_steps() { return bit(_engine.get_number_of_steps()) - 1; }
+
+// Steps started outside of the graph (e.g. prepared during the cooldown)
+// continue as running steps:
+void Step_graph::start_cycle(Step_set completed_steps) {
+  _completed_steps = completed_steps;
+  _running_steps = 0;
+  _owned_resources = 0;
+  for (byte step = 0; step < _engine.get_number_of_steps(); step++) {
+    if (!(completed_steps & bit(step)) && _engine.is_started(step)) {
+      start_step(step);
+    }
+  }
+  _cycle_start_time = millis();
+  _is_active = true;
+}
+
+void Step_graph::start_step(byte step) {
+  _running_steps |= bit(step);
+  _owned_resources |= pgm_read_word(&_resources[step]);
+}
+
+void Step_graph::run() {
+  for (byte step = 0; step < _engine.get_number_of_steps(); step++) {
+    if (_completed_steps & bit(step)) {
+      continue;
+    }
+    if (!(_running_steps & bit(step))) {
+      Step_set prerequisites = pgm_read_word(&_prerequisites[step]);
+      if ((prerequisites & ~_completed_steps) || (pgm_read_word(&_resources[step]) & _owned_resources)) {
+        continue;
+      }
+      start_step(step);
+    }
+    run_step(step);
+  }
+  if (is_cycle_completed()) {
+    _last_cycle_time = millis() - _cycle_start_time;
+  }
+}
+
+void Step_graph::run_step(byte step) {
+  _engine.do_stuff(step);
+  if (_engine.is_completed(step)) {
+    _running_steps &= ~bit(step);
+    _completed_steps |= bit(step);
+    _owned_resources &= ~pgm_read_word(&_resources[step]);
+  }
+}
+
+// Only the first running step keeps its state, the others will restart:
+byte Step_graph::stop() {
+  byte current_step = get_current_step();
+  for (byte step = current_step + 1; step < _engine.get_number_of_steps(); step++) {
+    _engine.reset_flags(step);
+  }
+  _is_active = false;
+  return current_step;
+}
+
+void Step_graph::cancel() {
+  for (byte step = 0; step < _engine.get_number_of_steps(); step++) {
+    if (_running_steps & bit(step)) {
+      _engine.reset_flags(step);
+    }
+  }
+  _running_steps = 0;
+  _is_active = false;
+}
+
+// GETTER ----------------------------------------------------------------------
+bool Step_graph::is_active() { return _is_active; }
+
+bool Step_graph::is_cycle_completed() { return _completed_steps == get_all_steps(); }
+
+byte Step_graph::get_current_step() {
+  for (byte step = 0; step < _engine.get_number_of_steps(); step++) {
+    if (!(_completed_steps & bit(step))) {
+      return step;
+    }
+  }
+  return 0;
+}
+
+unsigned long Step_graph::get_last_cycle_time() { return _last_cycle_time; }
+
+unsigned long Step_graph::get_serial_time() {
+  unsigned long serial_time = 0;
+  for (byte step = 0; step < _engine.get_number_of_steps(); step++) {
+    serial_time += _engine.get_profiler().get_mean_duration(step);
+  }
+  return serial_time;
+}
+
+unsigned long Step_graph::get_critical_path_time() {
+  Step_set path;
+  return get_longest_path(path);
+}
+
+Step_set Step_graph::get_critical_path() {
+  Step_set path;
+  get_longest_path(path);
+  return path;
+}
+
+// Longest finish time of every step in table order (prerequisites are earlier
+// steps), then back from the latest step along its longest prerequisite:
+unsigned long Step_graph::get_longest_path(Step_set &path) {
+  unsigned long finish_times[MAX_CYCLE_STEPS];
+  byte longest_prerequisites[MAX_CYCLE_STEPS];
+  byte last_step = 0;
+
+  for (byte step = 0; step < _engine.get_number_of_steps(); step++) {
+    Step_set prerequisites = pgm_read_word(&_prerequisites[step]);
+    unsigned long start_time = 0;
+    longest_prerequisites[step] = step; // none
+    for (byte prerequisite = 0; prerequisite < step; prerequisite++) {
+      if ((prerequisites & bit(prerequisite)) && finish_times[prerequisite] >= start_time) {
+        start_time = finish_times[prerequisite];
+        longest_prerequisites[step] = prerequisite;
+      }
+    }
+    finish_times[step] = start_time + _engine.get_profiler().get_mean_duration(step);
+    if (finish_times[step] >= finish_times[last_step]) {
+      last_step = step;
+    }
+  }
+
+  path = 0;
+  if (_engine.get_number_of_steps() == 0) {
+    return 0;
+  }
+  byte step = last_step;
+  path |= bit(step);
+  while (longest_prerequisites[step] != step) {
+    step = longest_prerequisites[step];
+    path |= bit(step);
+  }
+  return finish_times[last_step];
+}
@@ -1,35 +1,150 @@
 #ifndef CYCLESTEP_H
 #define CYCLESTEP_H
-#include <ArduinoSTL.h>
+#include <Arduino.h>
+#include <step_profiler.h>
 
-class Cycle_step {
+#ifndef MAX_CYCLE_STEPS
+#define MAX_CYCLE_STEPS STEP_PROFILER_MAX_STEPS
+#endif
+
+// A cycle step is a class with the (non virtual) functions do_initial_stuff(),
+// do_loop_stuff() and get_display_text() and one global object. The step table
+// holds their addresses, resolved at compile time and stored in flash:
+//
+//   const Cycle_step main_cycle_steps[] PROGMEM = {
+//       make_cycle_step<Aufwecken, aufwecken>(), ...};
+
+struct Cycle_step {
+  void (*do_initial_stuff)();
+  void (*do_loop_stuff)();
+  const __FlashStringHelper *(*get_display_text)();
+};
+
+// Resources (cylinders, timers) a step owns, one bit each. Declared in a table
+// in the same order as the step table, stored in flash:
+typedef unsigned int Step_resources;
+
+// A set of steps, one bit per step number:
+typedef unsigned int Step_set;
+
+template <class Step, Step &step> void do_initial_stuff_of() { step.do_initial_stuff(); }
+template <class Step, Step &step> void do_loop_stuff_of() { step.do_loop_stuff(); }
+template <class Step, Step &step> const __FlashStringHelper *get_display_text_of() { return step.get_display_text(); }
+
+template <class Step, Step &step> constexpr Cycle_step make_cycle_step() {
+  return {do_initial_stuff_of<Step, step>, do_loop_stuff_of<Step, step>, get_display_text_of<Step, step>};
+}
+
+// Runs the steps of a table and keeps their flags and durations:
+class Cycle_step_engine {
 public:
+  // FUNCTIONS:
+  Cycle_step_engine();
+  void setup(const Cycle_step *table, byte number_of_steps);
+
+  void do_stuff(byte step); // may be called by a running step for another step
+  void reset_flags(byte step);
+
+  // SETTER:
+  void set_loop_completed(); // of the step running in do_stuff()
+
+  // GETTER:
+  bool is_completed(byte step);
+  bool is_started(byte step); // initial stuff done, not completed yet
+  const __FlashStringHelper *get_display_text(byte step);
+  byte get_number_of_steps();
+  Step_profiler &get_profiler();
+
+private:
   // VARIABLES:
-  static int object_count;
+  const Cycle_step *_table; // PROGMEM
+  byte _number_of_steps;
+  byte _running_step;
+  bool _loop_completed[MAX_CYCLE_STEPS];
+  bool _innit_completed[MAX_CYCLE_STEPS];
+  Step_profiler _profiler;
 
   // FUNCTIONS:
-  Cycle_step();
-  void do_stuff();
-  void reset_flags();
+  void read_step(byte step, Cycle_step &entry);
+};
 
-  // VIRTUAL FUNCTIONS:
-  virtual void do_initial_stuff() = 0;
-  virtual void do_loop_stuff() = 0;
+// Runs a declared set of steps (e.g. the preparation of the next cycle) while
+// another step holds the sequence (e.g. a pause). The steps run one after the
+// other, a step only starts if none of its resources is owned by the holding
+// step. When the sequence reaches the first of these steps, finish() returns
+// the step to continue with, a started step continues without a restart.
+class Step_overlap {
+public:
+  // FUNCTIONS:
+  Step_overlap(Cycle_step_engine &engine);
+  void setup(const Step_resources *resources, byte first_step, byte number_of_steps);
 
-  // SETTER:
-  void set_loop_completed();
+  void run(byte holding_step); // called by the holding step
+  byte finish();
+  void cancel(); // the prepared steps will run again
+
+  // GETTER:
+  bool is_active(); // a prepared step has started
+  bool is_prepared(); // all steps completed
+  byte get_first_step();
+  byte get_number_of_completed_steps();
+
+private:
+  // VARIABLES:
+  Cycle_step_engine &_engine;
+  const Step_resources *_resources; // PROGMEM
+  byte _first_step;
+  byte _number_of_steps;
+  byte _completed_steps;
+  bool _is_step_started;
+  bool _is_active;
+
+  // FUNCTIONS:
+  Step_resources get_resources(byte step);
+};
+
+// Runs the steps of a cycle as a dependency graph: every step starts as soon
+// as its prerequisite steps are completed and none of its resources is owned
+// by a running step. Prerequisites must be earlier steps of the table, the
+// table order stays a valid serial order. The critical path is the longest
+// chain of prerequisites, based on the mean durations of the step profiler.
+class Step_graph {
+public:
+  // FUNCTIONS:
+  Step_graph(Cycle_step_engine &engine);
+  void setup(const Step_resources *resources, const Step_set *prerequisites); // PROGMEM
+
+  void start_cycle(Step_set completed_steps);
+  void run();
+  byte stop(); // returns the step to continue with in serial order
+  void cancel();
 
   // GETTER:
-  bool is_completed();
-  virtual String get_display_text() = 0;
+  bool is_active();
+  bool is_cycle_completed();
+  byte get_current_step(); // first running or waiting step
+  unsigned long get_last_cycle_time(); // [ms] measured
+  unsigned long get_serial_time(); // [ms] sum of the mean step durations
+  unsigned long get_critical_path_time(); // [ms]
+  Step_set get_critical_path();
 
 private:
   // VARIABLES:
-  bool _loop_completed;
-  bool _innit_completed;
+  Cycle_step_engine &_engine;
+  const Step_resources *_resources; // PROGMEM
+  const Step_set *_prerequisites; // PROGMEM
+  Step_set _running_steps;
+  Step_set _completed_steps;
+  Step_resources _owned_resources;
+  bool _is_active;
+  unsigned long _cycle_start_time;
+  unsigned long _last_cycle_time;
 
   // FUNCTIONS:
-  //n.A.
+  Step_set get_all_steps();
+  void run_step(byte step);
+  void start_step(byte step);
+  unsigned long get_longest_path(Step_set &path);
 };
 
 #endif
@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * edge_capture.cpp ************************************************************
+ *******************************************************************************/
+
+#include "edge_capture.h"
+#ifndef __AVR__
+#include <native_hal.h>
+#endif
+
+Edge_capture *Edge_capture::_inputs[EDGE_CAPTURE_MAX_INPUTS];
+byte Edge_capture::_input_count = 0;
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Edge_capture::Edge_capture(byte pin) {
+  _input_register = portInputRegister(digitalPinToPort(pin));
+  _bit_mask = digitalPinToBitMask(pin);
+  _state = false;
+  _head = 0;
+  _tail = 0;
+  _overrun_count = 0;
+  _last_latency = 0;
+  _max_latency = 0;
+  _latency_sum = 0;
+  _latency_count = 0;
+
+  if (_input_count < EDGE_CAPTURE_MAX_INPUTS) {
+    _inputs[_input_count] = this;
+    _input_count++;
+  }
+}
+
+// SETUP -----------------------------------------------------------------------
+void Edge_capture::begin() {
+  noInterrupts();
+  for (byte i = 0; i < _input_count; i++) {
+    _inputs[i]->_state = *_inputs[i]->_input_register & _inputs[i]->_bit_mask; // no edge at start
+  }
+#ifdef __AVR__
+  // TIMER 4, CTC MODE, PRESCALER 8, COMPARE MATCH A INTERRUPT:
+  TCCR4A = 0;
+  TCCR4B = _BV(WGM42) | _BV(CS41);
+  OCR4A = F_CPU / 8 / EDGE_CAPTURE_RATE - 1;
+  TCNT4 = 0;
+  TIMSK4 = _BV(OCIE4A);
+#else
+  native_attach_timer_interrupt(sample_all, 1000000UL / EDGE_CAPTURE_RATE);
+#endif
+  interrupts();
+}
+
+// PRODUCER (ISR) --------------------------------------------------------------
+void Edge_capture::sample_all() {
+  for (byte i = 0; i < _input_count; i++) {
+    _inputs[i]->sample();
+  }
+}
+
+void Edge_capture::sample() {
+  bool state = *_input_register & _bit_mask;
+  if (state == _state) {
+    return;
+  }
+  _state = state;
+
+  byte next_head = (_head + 1) & (EDGE_CAPTURE_QUEUE_SIZE - 1);
+  if (next_head == _tail) {
+    _overrun_count++; // loop did not consume in time, drop event
+    return;
+  }
+  _events[_head].time = micros();
+  _events[_head].state = state;
+  _head = next_head;
+}
+
+#ifdef __AVR__
+ISR(TIMER4_COMPA_vect) { Edge_capture::sample_all(); }
+#endif
+
+// CONSUMER (LOOP) -------------------------------------------------------------
+bool Edge_capture::get_state() { return _state; }
+
+bool Edge_capture::read_event(Edge_event &event) {
+  if (_tail == _head) {
+    return false;
+  }
+  event = _events[_tail];
+  _tail = (_tail + 1) & (EDGE_CAPTURE_QUEUE_SIZE - 1);
+  return true;
+}
+
+void Edge_capture::clear_events() { _tail = _head; }
+
+// REACTION LATENCY ------------------------------------------------------------
+void Edge_capture::record_reaction(const Edge_event &event) {
+  _last_latency = micros() - event.time;
+  if (_last_latency > _max_latency) {
+    _max_latency = _last_latency;
+  }
+  // Halve sum and count before they could overflow, the mean stays the same:
+  if (_latency_count == 0xFFFF || _latency_sum + _last_latency < _latency_sum) {
+    _latency_sum /= 2;
+    _latency_count /= 2;
+  }
+  _latency_sum += _last_latency;
+  _latency_count++;
+}
+
+unsigned long Edge_capture::get_last_latency() { return _last_latency; }
+
+unsigned long Edge_capture::get_mean_latency() {
+  if (_latency_count == 0) {
+    return 0;
+  }
+  return _latency_sum / _latency_count;
+}
+
+unsigned long Edge_capture::get_max_latency() { return _max_latency; }
+
+unsigned int Edge_capture::get_overrun_count() {
+  unsigned int overrun_count;
+  noInterrupts();
+  overrun_count = _overrun_count;
+  interrupts();
+  return overrun_count;
+}
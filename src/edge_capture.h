@@ -0,0 +1,88 @@
+/* *****************************************************************************
+ * edge_capture.h **************************************************************
+ * *****************************************************************************
+ * TIME STAMPED EDGES OF DIGITAL INPUTS (ATMEGA2560)
+ *
+ * A timer 4 interrupt samples all capture inputs at EDGE_CAPTURE_RATE and
+ * stores every change with its time [us] in a small event queue per input.
+ * A step reads the events instead of polling the pin once per loop, so it
+ * knows when the edge happened, however long the loop took.
+ *
+ * Sampling instead of pin change interrupts: the position switches are on
+ * port F (A0..A7), which has no pin change interrupts on the ATmega2560.
+ *
+ * record_reaction() measures the time from an edge until the step sees it,
+ * as last, mean and max value.
+ * Uses Timer 4 exclusively.
+ * *****************************************************************************
+ */
+
+#ifndef EdgeCapture_H_
+#define EdgeCapture_H_
+
+#include <Arduino.h>
+
+#ifndef EDGE_CAPTURE_RATE
+#define EDGE_CAPTURE_RATE 10000 // [Hz] => 100us resolution
+#endif
+
+#ifndef EDGE_CAPTURE_MAX_INPUTS
+#define EDGE_CAPTURE_MAX_INPUTS 4
+#endif
+
+#ifndef EDGE_CAPTURE_QUEUE_SIZE
+#define EDGE_CAPTURE_QUEUE_SIZE 8 // power of two
+#endif
+
+struct Edge_event {
+  unsigned long time; // [us]
+  bool state; // state after the edge
+};
+
+class Edge_capture {
+
+public:
+  // FUNCTIONS:
+  Edge_capture(byte pin);
+
+  static void begin(); // start sampling of all inputs
+
+  bool get_state();
+  bool read_event(Edge_event &event);
+  void clear_events();
+
+  void record_reaction(const Edge_event &event);
+  unsigned long get_last_latency(); // [us]
+  unsigned long get_mean_latency(); // [us]
+  unsigned long get_max_latency(); // [us]
+  unsigned int get_overrun_count();
+
+  // Called by the timer interrupt:
+  static void sample_all();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void sample();
+
+  // VARIABLES:
+  static Edge_capture *_inputs[EDGE_CAPTURE_MAX_INPUTS];
+  static byte _input_count;
+
+  volatile uint8_t *_input_register;
+  byte _bit_mask;
+  volatile bool _state;
+
+  Edge_event _events[EDGE_CAPTURE_QUEUE_SIZE];
+  volatile byte _head; // written by the ISR only
+  volatile byte _tail; // written by the loop only
+  volatile unsigned int _overrun_count;
+
+  unsigned long _last_latency;
+  unsigned long _max_latency;
+  unsigned long _latency_sum;
+  unsigned int _latency_count;
+};
+#endif /* EdgeCapture_H_ */
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * fill_controller.cpp *********************************************************
+ *******************************************************************************/
+
+#include "fill_controller.h"
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Fill_controller::Fill_controller() {
+  reset_gains();
+  _target_force = 0;
+  _tolerance = 0;
+  _force_before_pulse = 0;
+  _pulse = 0;
+  _pulse_count = 0;
+  _no_rise_count = 0;
+  _has_failed = false;
+  _fallback_count = 0;
+}
+
+void Fill_controller::reset_gains() {
+  for (byte i = 0; i < end_of_fill_gain_enum; i++) {
+    _gains[i] = FILL_CONTROLLER_DEFAULT_GAIN;
+  }
+}
+
+// FILL ------------------------------------------------------------------------
+void Fill_controller::start(int target_force, int tolerance) {
+  _target_force = target_force;
+  _tolerance = tolerance;
+  _pulse = 0;
+  _pulse_count = 0;
+  _no_rise_count = 0;
+  _has_failed = false;
+}
+
+unsigned int Fill_controller::get_next_pulse(int force) {
+  _pulse = 0;
+  if (_has_failed || force + _tolerance > _target_force) {
+    return 0; // same condition as the fixed pulses
+  }
+  if (_pulse_count >= FILL_CONTROLLER_MAX_PULSES) {
+    fail();
+    return 0;
+  }
+  unsigned int gain = _gains[_pulse_count ? top_up_gain : first_pulse_gain];
+  long missing_force = _target_force - _tolerance / 2 - force;
+  unsigned long pulse = ((unsigned long)missing_force << 8) / gain;
+  _pulse = constrain(pulse, (unsigned long)FILL_CONTROLLER_MIN_PULSE, (unsigned long)FILL_CONTROLLER_MAX_PULSE);
+  _force_before_pulse = force;
+  _pulse_count++;
+  return _pulse;
+}
+
+void Fill_controller::learn(int force) {
+  if (_pulse == 0) {
+    return;
+  }
+  int force_increase = force - _force_before_pulse;
+  if (force_increase <= 0) {
+    _no_rise_count++;
+    if (_no_rise_count >= FILL_CONTROLLER_MAX_NO_RISE) {
+      fail();
+    }
+    return;
+  }
+  _no_rise_count = 0;
+
+  unsigned long observed_gain = ((unsigned long)force_increase << 8) / _pulse;
+  const unsigned long min_gain = FILL_CONTROLLER_MIN_GAIN;
+  const unsigned long max_gain = FILL_CONTROLLER_MAX_GAIN;
+  observed_gain = constrain(observed_gain, min_gain, max_gain);
+  unsigned int &gain = _gains[_pulse_count > 1 ? top_up_gain : first_pulse_gain];
+  gain = (gain + observed_gain) / 2;
+}
+
+void Fill_controller::fail() {
+  _has_failed = true;
+  if (_fallback_count < 0xFFFF) {
+    _fallback_count++;
+  }
+  reset_gains();
+}
+
+// GETTER ----------------------------------------------------------------------
+bool Fill_controller::has_failed() { return _has_failed; }
+
+unsigned int Fill_controller::get_gain(byte gain) { return _gains[gain]; }
+
+byte Fill_controller::get_pulse_count() { return _pulse_count; }
+
+unsigned int Fill_controller::get_fallback_count() { return _fallback_count; }
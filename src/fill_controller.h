@@ -0,0 +1,80 @@
+/* *****************************************************************************
+ * fill_controller.h ***********************************************************
+ * *****************************************************************************
+ * ADAPTIVE PULSE SIZING FOR FILLING THE PNEUMATIC SPRING
+ *
+ * The valve gain (force increase per millisecond of filling) is learned from
+ * every pulse: the settled force before and after the pulse gives the gain
+ * observed, the gain used is the mean of the old gain and the observed one.
+ * The next pulse is sized to land in the middle of the tolerance band below
+ * the target, so a pulse does not overshoot as long as the gain is right.
+ *
+ * The gain depends on the pressure, the first pulse of a fill (from vented)
+ * and the top up pulses have a gain each. The gains stay learned from one
+ * cycle to the next.
+ *
+ * The controller fails if the force does not rise twice in a row or the
+ * target is not reached after FILL_CONTROLLER_MAX_PULSES. The caller then
+ * falls back to fixed pulses, the gains start again from the default.
+ *
+ * Gains are in fixed point Q8 [N/ms * 256].
+ * *****************************************************************************
+ */
+
+#ifndef FillController_H_
+#define FillController_H_
+
+#include <Arduino.h>
+
+#ifndef FILL_CONTROLLER_DEFAULT_GAIN
+#define FILL_CONTROLLER_DEFAULT_GAIN 2048 // [N/ms Q8] 8 N/ms, high: unknown valves undershoot
+#endif
+
+#define FILL_CONTROLLER_MIN_GAIN 16 // [N/ms Q8]
+#define FILL_CONTROLLER_MAX_GAIN 16384 // [N/ms Q8]
+#define FILL_CONTROLLER_MIN_PULSE 10 // [ms] shortest full opening of the valve
+#define FILL_CONTROLLER_MAX_PULSE 3000 // [ms]
+#define FILL_CONTROLLER_MAX_PULSES 8
+#define FILL_CONTROLLER_MAX_NO_RISE 2
+
+enum fill_gain {
+  first_pulse_gain,
+  top_up_gain,
+  end_of_fill_gain_enum
+};
+
+class Fill_controller {
+
+public:
+  // FUNCTIONS:
+  Fill_controller();
+
+  void start(int target_force, int tolerance); // [N]
+  unsigned int get_next_pulse(int force); // [ms], 0 if on target or failed
+  void learn(int force); // settled force after the pulse [N]
+  bool has_failed();
+
+  unsigned int get_gain(byte gain); // [N/ms Q8]
+  byte get_pulse_count(); // pulses of the current fill
+  unsigned int get_fallback_count();
+  void reset_gains();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void fail();
+
+  // VARIABLES:
+  unsigned int _gains[end_of_fill_gain_enum];
+  int _target_force;
+  int _tolerance;
+  int _force_before_pulse;
+  unsigned int _pulse;
+  byte _pulse_count;
+  byte _no_rise_count;
+  bool _has_failed;
+  unsigned int _fallback_count;
+};
+#endif /* FillController_H_ */
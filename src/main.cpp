@@ -12,17 +12,30 @@
  * *****************************************************************************
  */
 
-#include <ArduinoSTL.h> //       https://github.com/mike-matera/ArduinoSTL
 #include <Controllino.h> //      PIO Controllino Library
-#include <Cylinder.h> //         https://github.com/chischte/cylinder-library
-#include <Debounce.h> //         https://github.com/chischte/debounce-library
 #include <EEPROM_Counter.h> //   https://github.com/chischte/eeprom-counter-library
 #include <Insomnia.h> //         https://github.com/chischte/insomnia-delay-library
-#include <Nextion.h> //          PIO Nextion library
-#include <SD.h> //               PIO Adafruit SD library
 
-#include <cycle_step.h> //       blueprint of a cycle step
+#include <command_queue.h> //    deferred commands from the display
+#include <cycle_step.h> //       step table and engine
+#include <edge_capture.h> //     time stamped edges of the position switches
+#include <fill_controller.h> //  learns the pulses of the startdruck
+#include <memory_monitor.h> //   RAM usage and high water mark
+#include <nextion_queue.h> //    non blocking display transmit queue
+#include <nextion_touch.h> //    parser for display touch events
+#include <nextion_widgets.h> //  registry of all display items
+#include <process_image.h> //    inputs and outputs latched per scan
+#include <pressure_filter.h> //  fixed point pressure processing
+#include <pressure_sampler.h> // timer triggered pressure sampling
+#include <scan_monitor.h> //     loop scan time histogram
+#include <startdruck_parameters.h> // pulses of the step startdruck
+#include <task_scheduler.h> //   fixed period tasks of the main loop
+#include <thermal_model.h> //    temperature of the welding tool
+#include <valve_scheduler.h> //  timer driven valve strokes
+#include <vent_detector.h> //    predicts the end of venting
+#include <weld_detector.h> //    releases the weld step when the tool is ready
 #include <state_controller.h> // keeps track of machine states
+#include <step_watchdog.h> //    timeout of every single step
 
 // !!!!!!!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!!!--------------|
 // !!!!!!!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!!!--------------|
@@ -32,38 +45,50 @@ bool is_in_display_debug_mode = false; // MUST BE FALSE IN PRODUCTION !!!<--|
 //                                                                          |
 int max_tool_force = 2500; // [N] / 260er->2500 / 450er->4500 --------------|
 //                                                                          |
+bool runs_steps_in_parallel = false; // auto mode: step graph --------------|
+//                                                                          |
 // !!!!!!!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!!!--------------|
 // !!!!!!!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!!!--------------|
 // !!!!!!!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!! !!!!!!!!!!!!!!!!!!--------------|
 
 // PRE-SETUP SECTION / PIN LAYOUT **********************************************
 
+// PROCESS IMAGE, DEFINE BEFORE ITS INPUTS AND OUTPUTS:
+Process_image process_image;
+
 // INPUT PINS / SENSORS:
 
 const byte DRUCKSENSOR = CONTROLLINO_A7; // 0-10V = 0-12barg
-Debounce bandsensor_oben(CONTROLLINO_A0);
-Debounce bandsensor_unten(CONTROLLINO_A1);
-Debounce taster_startposition(CONTROLLINO_A2);
-Debounce taster_endposition(CONTROLLINO_A3);
+Pressure_sampler pressure_sampler(DRUCKSENSOR);
+Image_input bandsensor_oben(process_image, CONTROLLINO_A0);
+Image_input bandsensor_unten(process_image, CONTROLLINO_A1);
+Edge_capture taster_startposition(CONTROLLINO_A2);
+Edge_capture taster_endposition(CONTROLLINO_A3);
+Image_input werkzeug_bereit(process_image, CONTROLLINO_A4); // optional, see weld_parameters
 
 // OUTPUT PINS / VALVES / MOTORS / RELAYS:
-Cylinder zyl_hauptluft(CONTROLLINO_D7);
-Cylinder zyl_800_abluft(CONTROLLINO_D1);
-Cylinder zyl_800_zuluft(CONTROLLINO_D0);
-Cylinder zyl_startklemme(CONTROLLINO_D2);
-Cylinder zyl_wippenhebel(CONTROLLINO_D5);
-Cylinder zyl_spanntaste(CONTROLLINO_D3);
-Cylinder zyl_schweisstaste(CONTROLLINO_D4);
-Cylinder zyl_tool_niederhalter(CONTROLLINO_D9);
-Cylinder zyl_block_messer(CONTROLLINO_D6);
-Cylinder zyl_block_klemmrad(CONTROLLINO_D8);
-Cylinder zyl_block_foerdermotor(CONTROLLINO_R5);
-Cylinder zyl_singal_green(CONTROLLINO_D10);
-Cylinder zyl_singal_red(CONTROLLINO_D11);
+Image_output zyl_hauptluft(process_image, CONTROLLINO_D7);
+Image_output zyl_800_abluft(process_image, CONTROLLINO_D1);
+Image_output zyl_800_zuluft(process_image, CONTROLLINO_D0);
+Image_output zyl_startklemme(process_image, CONTROLLINO_D2);
+Image_output zyl_wippenhebel(process_image, CONTROLLINO_D5);
+Image_output zyl_spanntaste(process_image, CONTROLLINO_D3);
+Image_output zyl_schweisstaste(process_image, CONTROLLINO_D4);
+Image_output zyl_tool_niederhalter(process_image, CONTROLLINO_D9);
+Image_output zyl_block_messer(process_image, CONTROLLINO_D6);
+Image_output zyl_block_klemmrad(process_image, CONTROLLINO_D8);
+Image_output zyl_block_foerdermotor(process_image, CONTROLLINO_R5);
+Image_output zyl_singal_green(process_image, CONTROLLINO_D10);
+Image_output zyl_singal_red(process_image, CONTROLLINO_D11);
+
+// STROKES SWITCHED BY THE TIMER INTERRUPT:
+Valve_scheduler valve_scheduler;
+Valve_stroke stroke_messer(valve_scheduler, zyl_block_messer);
+Valve_stroke stroke_schweisstaste(valve_scheduler, zyl_schweisstaste);
+Valve_stroke stroke_wippenhebel(valve_scheduler, zyl_wippenhebel);
+Valve_stroke stroke_800_fuellen(valve_scheduler, zyl_800_zuluft); // adaptive startdruck
 
 Insomnia delay_cycle_step;
-Insomnia delay_force_update;
-Insomnia delay_tacho_update;
 Insomnia delay_minimum_filltime;
 Insomnia delay_minimum_waittime;
 
@@ -71,8 +96,24 @@ Insomnia spinner_step_timeout(500);
 Insomnia timeout_machine_stopped(15000);
 Insomnia timeout_reset_button(5000); // pushtime to reset counter
 Insomnia timeout_long_pause;
+Insomnia delay_statistics_row; // one row of the statistics page
 
 State_controller state_controller;
+Pressure_filter pressure_filter;
+Memory_monitor memory_monitor;
+Scan_monitor scan_monitor;
+Task_scheduler task_scheduler;
+
+// TASKS OF THE MAIN LOOP (ALSO THE SECTIONS OF THE SCAN MONITOR):
+enum loop_task {
+  task_safety, // strap detectors, timeout, signal light
+  task_pressure,
+  task_steps,
+  task_display,
+  task_telemetry, // USB serial commands
+  end_of_task_enum
+};
+Scheduled_task_state task_states[end_of_task_enum];
 
 // GLOBAL VARIABLES ------------------------------------------------------------
 // bool (1/0 or true/false)
@@ -84,14 +125,37 @@ State_controller state_controller;
 byte cycle_step = 0;
 byte timeout_count = 0;
 
-unsigned long runtime;
-unsigned long runtime_stopwatch;
-
-String error_message = "";
+enum error_messages {
+  no_error,
+  error_kein_band,
+  error_stopped,
+  error_run_reset,
+  error_step_timeout,
+  error_valve_schedule,
+};
+byte error_message = no_error;
 
-float pressure_float;
+int pressure_mbar;
 int force_int;
 
+// fill time [ms], wait time [ms], confirmations, minimum inflation [N],
+// adaptive, settle time [ms], adaptive confirmations:
+Startdruck_parameters startdruck_parameters = {90, 250, 14, 60, false, 150, 2};
+Fill_controller fill_controller;
+
+// predictive, residual pressure [mbar] (well below the 100 mbar threshold of
+// the steps), confidence:
+Vent_parameters vent_parameters = {false, 30, 3};
+Vent_detector vent_detector;
+
+// early release (needs the ready input), minimum time [ms], uses ready input:
+Weld_parameters weld_parameters = {false, 5000, true};
+Weld_detector weld_detector;
+
+// adaptive cooldown, heating rate [0.1K/s], time constant [s], limit [0.1K]:
+Thermal_parameters thermal_parameters = {false, 20, 300, 400};
+Thermal_model thermal_model;
+
 // SET UP EEPROM COUNTER ********************************************************
 enum eeprom_counter {
   startfuelldruck,
@@ -100,6 +164,10 @@ enum eeprom_counter {
   cycles_in_a_row,
   long_cooldown_time,
   strap_eject_feed_time,
+  tool_temperature, // [0.1K] state of the thermal model
+  first_step_timeout, // [ms] timeout of every step, 0 = default, order = step table
+  last_step_timeout = first_step_timeout + 13,
+  eeprom_layout, // EEPROM_LAYOUT_VERSION once the values are migrated
   end_of_eeprom_enum
 };
 int number_of_eeprom_values = end_of_eeprom_enum;
@@ -107,22 +175,32 @@ int eeprom_min_address = 0;
 int eeprom_max_address = 4095;
 EEPROM_Counter eeprom_counter;
 
+// Layout 1 had the values up to strap_eject_feed_time. The counter library
+// gives no guarantee that a value keeps its place when values are added, the
+// values of layout 1 are copied once (see migrate_eeprom_layout()):
+const long EEPROM_LAYOUT_VERSION = 0x4B504C02; // "KPL", layout 2
+const int NUMBER_OF_EEPROM_VALUES_LAYOUT_1 = tool_temperature;
+
 // DECLARE FUNCTIONS IF NEEDED FOR THE COMPILER: *******************************
 
-String get_main_cycle_display_string();
 void reset_flag_of_current_step();
-void display_text_in_field(String text, String text_field);
-void send_to_nextion();
-void clear_text_field(String text_field);
-void clear_info_field();
+bool send_to_nextion();
 void reset_spinner_picture();
-void display_text_in_info_field(String);
-
-// CREATE VECTOR CONTAINER FOR THE CYCLE STEPS OBJECTS *************************
-
-int Cycle_step::object_count = 0; // enable object counting
-std::vector<Cycle_step *> main_cycle_steps;
-void reset_flag_of_current_step() { main_cycle_steps[state_controller.get_current_step()]->reset_flags(); }
+void print_memory_report();
+void run_safety_task();
+void run_pressure_task();
+void run_step_task();
+void run_display_task();
+void run_telemetry_task();
+
+// CYCLE STEP ENGINE ***********************************************************
+
+Cycle_step_engine cycle_steps;
+Step_overlap step_overlap(cycle_steps); // prepares the next strap during the cooldown
+Step_graph step_graph(cycle_steps); // runs independent steps in parallel (auto mode)
+Step_watchdog step_watchdog(cycle_steps);
+void reset_flag_of_current_step() { cycle_steps.reset_flags(state_controller.get_current_step()); }
+void set_loop_completed() { cycle_steps.set_loop_completed(); } // called by the running step
 
 // NON NEXTION FUNCTIONS *******************************************************
 
@@ -140,16 +218,49 @@ void pneumatic_spring_block() {
   zyl_800_zuluft.set(0);
   zyl_800_abluft.set(1);
 }
+void start_vent_detector() {
+  if (vent_parameters.is_predictive) {
+    vent_detector.start(state_controller.get_current_step(), vent_parameters.residual_pressure,
+                        vent_parameters.confidence);
+  }
+}
 
 void pneumatic_spring_build_pressure() {
   zyl_800_zuluft.set(1);
   zyl_800_abluft.set(1);
 }
 
+// POSITION SWITCHES -----------------------------------------------------------
+// A step starts watching a switch with start_watching_switch() and reads its
+// edges with read_switch_edges(). The first contact holds the time [us] the
+// switch has been reached, also if the loop was busy at that moment.
+// The latency is recorded when the step sees the edge, before any margin of
+// the step, so the latencies of all switches are comparable.
+
+void start_watching_switch(Edge_capture &position_switch, Edge_event &first_contact, bool &is_reached) {
+  position_switch.clear_events();
+  is_reached = position_switch.get_state(); // already reached
+  first_contact.time = micros();
+  first_contact.state = is_reached;
+}
+
+void read_switch_edges(Edge_capture &position_switch, Edge_event &first_contact, bool &is_reached) {
+  Edge_event edge;
+  while (position_switch.read_event(edge)) {
+    if (edge.state && !is_reached) {
+      first_contact = edge;
+      is_reached = true;
+      position_switch.record_reaction(first_contact);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 
 void reset_cylinders() {
 
+  valve_scheduler.cancel_all();
+
   zyl_hauptluft.set(1);
   zyl_wippenhebel.set(0);
   zyl_spanntaste.set(0);
@@ -164,6 +275,8 @@ void reset_cylinders() {
 void reset_state_controller() {
   state_controller.set_machine_stop();
   state_controller.set_step_mode();
+  step_graph.cancel();
+  step_overlap.cancel();
   reset_flag_of_current_step();
   state_controller.set_current_step_to(0);
   reset_flag_of_current_step();
@@ -173,8 +286,7 @@ void reset_state_controller() {
 void reset_machine() {
   reset_cylinders();
   reset_state_controller();
-  clear_info_field();
-  error_message = "";
+  error_message = no_error;
   timeout_machine_stopped.reset_time();
   timeout_long_pause.set_time(0);
 }
@@ -183,239 +295,245 @@ void stop_machine() {
   zyl_hauptluft.set(0);
   state_controller.set_step_mode();
   state_controller.set_machine_stop();
+  step_graph.cancel(); // no parallel or prepared step continues after the stop
+  step_overlap.cancel();
   reset_cylinders();
 }
 
+// A stroke that could not be scheduled stops the machine:
+void start_stroke(Valve_stroke &stroke, unsigned long push_time, unsigned long release_time) {
+  if (!stroke.start(push_time, release_time)) {
+    stop_machine();
+    error_message = error_valve_schedule;
+    state_controller.set_error_mode();
+  }
+}
+
 // NEXTION VARIABLES -----------------------------------------------------------
+Nextion_queue nextion_queue(Serial2);
+Nextion_touch_parser nextion_touch_parser(Serial2);
 int nex_current_page;
 bool spinner_is_running;
 int spinner_pics_array[5] = {22, 23, 24, 25, 26}; // 0-4
 int tacho_pics_array[12] = {21, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37}; //0-11
 
-byte nex_current_spinner_pos;
 byte current_spinner_pos;
-byte nex_current_tacho_pos;
-byte current_tacho_pos;
-
-// NEXTION SWITCH STATES LIST --------------------------------------------------
-// Every nextion switch button (dualstate) needs a switchstate variable to
-// control switchtoggle. Every nextion button (momentary) needs a variable to
-// prevent screen flickering.
-
-bool nex_state_zyl_hauptluft;
-bool nex_state_zyl_800_zuluft;
-bool nex_state_zyl_800_abluft;
-bool nex_state_zyl_startklemme;
-bool nex_state_zyl_wippenhebel;
-bool nex_state_zyl_spanntaste;
-bool nex_state_zyl_messer;
-bool nex_state_zyl_foerdern;
-bool nex_state_zyl_schweisstaste;
-bool nex_state_machine_running;
-bool nex_state_step_mode = true;
-byte nex_state_cycle_step;
-int nex_state_force_int;
-long nex_state_cycles_in_a_row;
-long nex_state_long_cooldown_time;
-long nex_state_feed_time;
-long nex_state_shorttime_counter;
-long nex_state_longtime_counter;
-long nex_state_startfuelldruck;
-long nex_state_restpausenzeit;
-long button_push_stopwatch;
-float nex_state_federdruck;
-String nex_state_error_message = "INFO";
+
+// NEXTION DISPLAY ITEMS -------------------------------------------------------
+// Every item on the display is an entry of the widget table, the registry keeps
+// track of the value displayed. Enum order = table order !
+
+enum nextion_widget {
+  // PAGE 1 - LEFT SIDE:
+  widget_spinner,
+  widget_tacho,
+  widget_force,
+  widget_cycle_name,
+  widget_play_pause,
+  widget_mode,
+  widget_info,
+  // PAGE 1 - RIGHT SIDE:
+  widget_zyl_800_zuluft,
+  widget_zyl_800_abluft,
+  widget_zyl_startklemme,
+  widget_zyl_wippenhebel,
+  widget_zyl_spanntaste,
+  widget_zyl_messer,
+  widget_zyl_foerdern,
+  widget_zyl_schweisstaste,
+  widget_zyl_hauptluft,
+  // PAGE 2:
+  widget_cycles_in_a_row,
+  widget_cooldown_time,
+  widget_feed_time,
+  widget_startfuelldruck,
+  widget_pressure,
+  // PAGE 3:
+  widget_shorttime_counter,
+  widget_longtime_counter,
+  end_of_widget_enum
+};
+Nextion_widget_state nextion_widget_states[end_of_widget_enum];
+Nextion_widgets nextion_widgets;
 
 // NEXTION OBJECTS -------------------------------------------------------------
 
 // PAGE 0:
-NexPage nex_page_0 = NexPage(0, 0, "page_0");
+const Nextion_component nex_page_0 = {0, 0}; // page_0
 
 // PAGE 1 - LEFT SIDE:
-NexPage nex_page_1 = NexPage(1, 0, "page1");
-NexButton nex_button_stepback = NexButton(1, 6, "b1");
-NexButton nex_button_stepnxt = NexButton(1, 7, "b2");
-NexButton nex_button_reset_machine = NexButton(1, 5, "b0");
-NexDSButton nex_button_play_pause = NexDSButton(1, 22, "play");
-NexDSButton nex_button_mode = NexDSButton(1, 4, "bt1");
+const Nextion_component nex_page_1 = {1, 0}; // page1
+const Nextion_component nex_button_stepback = {1, 6}; // b1
+const Nextion_component nex_button_stepnxt = {1, 7}; // b2
+const Nextion_component nex_button_reset_machine = {1, 5}; // b0
+const Nextion_component nex_button_play_pause = {1, 22}; // play
+const Nextion_component nex_button_mode = {1, 4}; // bt1
 
 // PAGE 1 - RIGHT SIDE
-NexDSButton nex_zyl_800_zuluft = NexDSButton(1, 13, "bt5");
-NexDSButton nex_zyl_800_abluft = NexDSButton(1, 12, "bt4");
-NexDSButton nex_zyl_startklemme = NexDSButton(1, 11, "bt3");
-NexButton nex_zyl_wippenhebel = NexButton(1, 10, "b5");
-NexButton nex_zyl_spanntaste = NexButton(1, 9, "b4");
-NexButton nex_zyl_schweisstaste = NexButton(1, 8, "b3");
-NexDSButton nex_zyl_messer = NexDSButton(1, 16, "b6");
-NexButton nex_zyl_foerdern = NexButton(1, 17, "b7");
-NexButton nex_zyl_hauptluft = NexButton(1, 15, "bt6");
+const Nextion_component nex_zyl_800_zuluft = {1, 13}; // bt5
+const Nextion_component nex_zyl_800_abluft = {1, 12}; // bt4
+const Nextion_component nex_zyl_startklemme = {1, 11}; // bt3
+const Nextion_component nex_zyl_wippenhebel = {1, 10}; // b5
+const Nextion_component nex_zyl_spanntaste = {1, 9}; // b4
+const Nextion_component nex_zyl_schweisstaste = {1, 8}; // b3
+const Nextion_component nex_zyl_messer = {1, 16}; // b6
+const Nextion_component nex_zyl_foerdern = {1, 17}; // b7
+const Nextion_component nex_zyl_hauptluft = {1, 15}; // bt6
 
 // PAGE 2:
-NexPage nex_page_2 = NexPage(2, 0, "page2");
-NexButton nex_button_1_left = NexButton(2, 5, "b1");
-NexButton nex_button_1_right = NexButton(2, 6, "b2");
-NexButton nex_button_2_left = NexButton(2, 8, "b0");
-NexButton nex_button_2_right = NexButton(2, 10, "b3");
-NexButton nex_button_3_left = NexButton(2, 12, "b4");
-NexButton nex_button_3_right = NexButton(2, 14, "b5");
-NexButton nex_button_4_left = NexButton(2, 16, "b6");
-NexButton nex_button_4_right = NexButton(2, 18, "b7");
+const Nextion_component nex_page_2 = {2, 0}; // page2
+const Nextion_component nex_button_1_left = {2, 5}; // b1
+const Nextion_component nex_button_1_right = {2, 6}; // b2
+const Nextion_component nex_button_2_left = {2, 8}; // b0
+const Nextion_component nex_button_2_right = {2, 10}; // b3
+const Nextion_component nex_button_3_left = {2, 12}; // b4
+const Nextion_component nex_button_3_right = {2, 14}; // b5
+const Nextion_component nex_button_4_left = {2, 16}; // b6
+const Nextion_component nex_button_4_right = {2, 18}; // b7
 
 // PAGE 3:
-NexPage nex_page_3 = NexPage(3, 0, "page3");
-NexButton nex_button_reset_shorttime_counter = NexButton(3, 6, "b4");
+const Nextion_component nex_page_3 = {3, 0}; // page3
+const Nextion_component nex_button_reset_shorttime_counter = {3, 6}; // b4
 
-char buffer[100] = {0}; // This is needed only if you are going to receive a
-    // text from the display. You can remove it otherwise.
+// PAGE 4 - STATISTICS (ONE TEXT FIELD PER STEP, t0 ... t13):
+const Nextion_component nex_page_4 = {4, 0}; // page4
 
-// NEXTION TOUCH EVENT LISTENERS -----------------------------------------------
+// NEXTION TOUCH EVENT FUNCTIONS -----------------------------------------------
+// Callbacks that change the machine post a command, the step task executes
+// the commands at the start of its run (execute_touch_commands()).
+
+enum touch_command {
+  command_toggle_machine_running,
+  command_toggle_step_auto_mode,
+  command_step_back,
+  command_step_next,
+  command_reset_machine,
+  command_set_valve, // argument: manual_valve, state
+  command_toggle_valve, // argument: manual_valve
+  command_adjust_setting, // argument: setting_slider, state: increase
+  command_reset_shorttime_counter
+};
 
-NexTouch *nex_listen_list[] = {
-    // PAGE 0:
-    &nex_page_0,
-    // PAGE 1 - LEFT SIDE:
-    &nex_page_1, &nex_button_stepback, &nex_button_stepnxt, &nex_button_reset_machine, &nex_button_play_pause,
-    &nex_button_mode,
-    // PAGE 1 - RIGHT SIDE:
-    &nex_zyl_foerdern, &nex_zyl_messer, &nex_zyl_startklemme, &nex_zyl_800_zuluft, &nex_zyl_800_abluft,
-    &nex_zyl_wippenhebel, &nex_zyl_spanntaste, &nex_zyl_schweisstaste, &nex_zyl_hauptluft,
-    // PAGE 2:
-    &nex_page_2, &nex_button_1_left, &nex_button_1_right, &nex_button_2_left, &nex_button_2_right, &nex_button_3_left,
-    &nex_button_3_right, &nex_button_4_left, &nex_button_4_right,
-    // PAGE 3:
-    &nex_page_3, &nex_button_reset_shorttime_counter, //
-    NULL};
+enum manual_valve {
+  valve_800_zuluft,
+  valve_800_abluft,
+  valve_startklemme,
+  valve_wippenhebel,
+  valve_spanntaste,
+  valve_schweisstaste,
+  valve_messer,
+  valve_foerdern, // klemmrad and foerdermotor
+  valve_hauptluft
+};
 
-// NEXTION TOUCH EVENT FUNCTIONS -----------------------------------------------
+enum setting_slider {
+  slider_cycles_in_a_row,
+  slider_cooldown_time,
+  slider_feed_time,
+  slider_startfuelldruck
+};
+
+Command_queue touch_commands;
 
 // TOUCH EVENT FUNCTIONS PAGE CHANGES ------------------------------------------
 
-void nex_page_0_push_callback(void *ptr) { nex_current_page = 0; }
+void nex_page_0_push_callback(void *ptr) {
+  nex_current_page = 0;
+  nextion_queue.discard_pending();
+}
 
 void nex_page_1_push_callback(void *ptr) {
   nex_current_page = 1;
-
-  // REFRESH BUTTON STATES:
-  nex_state_cycle_step = -1;
-  nex_state_step_mode = 1;
-  nex_state_error_message = "INFO";
-  nex_state_zyl_800_zuluft = 0;
-  nex_state_zyl_800_abluft = 1; // INVERTED VALVE LOGIC
-  nex_state_zyl_startklemme = 0;
-  nex_state_zyl_wippenhebel = 0;
-  nex_state_zyl_spanntaste = 0;
-  nex_state_zyl_messer = 0;
-  nex_state_zyl_foerdern = 0;
-  nex_state_zyl_schweisstaste = 0;
-  nex_state_machine_running = 0;
-  nex_state_zyl_hauptluft = 0;
-  nex_state_force_int = -5;
-  nex_current_spinner_pos = 1;
-  nex_current_tacho_pos = 0;
+  nextion_queue.discard_pending();
+  nextion_widgets.invalidate_page(1); // REFRESH BUTTON STATES
 }
 
 void nex_page_2_push_callback(void *ptr) {
   nex_current_page = 2;
-  // REFRESH BUTTON STATES:
-  nex_state_cycles_in_a_row = 0;
-  nex_state_long_cooldown_time = 0;
-  nex_state_feed_time = 0;
-  nex_state_startfuelldruck = 0;
-  nex_state_federdruck = 10000;
+  nextion_queue.discard_pending();
+  nextion_widgets.invalidate_page(2); // REFRESH BUTTON STATES
 }
 
 void nex_page_3_push_callback(void *ptr) {
   nex_current_page = 3;
-  // REFRESH BUTTON STATES:
-  nex_state_shorttime_counter = 0;
-  nex_state_longtime_counter = 0;
+  nextion_queue.discard_pending();
+  nextion_widgets.invalidate_page(3); // REFRESH BUTTON STATES
+}
+
+void nex_page_4_push_callback(void *ptr) {
+  nex_current_page = 4;
+  nextion_queue.discard_pending();
 }
 
 // TOUCH EVENT FUNCTIONS PAGE 1 - LEFT SIDE ------------------------------------
 
 void nex_button_play_pause_push_callback(void *ptr) { //
-  state_controller.toggle_machine_running_state();
-  nex_state_machine_running = !nex_state_machine_running;
+  touch_commands.post(command_toggle_machine_running);
+  nextion_widgets.toggle_displayed_value(widget_play_pause);
 }
 
 void nex_button_play_pause_pop_callback(void *ptr) {}
 
 void nex_button_mode_push_callback(void *ptr) {
-  state_controller.toggle_step_auto_mode();
-  nex_state_step_mode = state_controller.is_in_step_mode();
+  touch_commands.post(command_toggle_step_auto_mode);
+  nextion_widgets.toggle_displayed_value(widget_mode);
 }
-void nex_button_stepback_push_callback(void *ptr) {
-  state_controller.set_machine_stop();
-  reset_flag_of_current_step();
-  state_controller.set_step_mode();
-  state_controller.switch_to_previous_step();
-  reset_flag_of_current_step();
-  display_text_in_info_field("");
-}
-void nex_button_stepnxt_push_callback(void *ptr) {
-  state_controller.set_machine_stop();
-  reset_flag_of_current_step();
-  state_controller.set_step_mode();
-  state_controller.switch_to_next_step();
-  reset_flag_of_current_step();
-  display_text_in_info_field("");
-}
-void nex_button_reset_machine_push_callback(void *ptr) { reset_machine(); }
+void nex_button_stepback_push_callback(void *ptr) { touch_commands.post(command_step_back); }
+void nex_button_stepnxt_push_callback(void *ptr) { touch_commands.post(command_step_next); }
+void nex_button_reset_machine_push_callback(void *ptr) { touch_commands.post(command_reset_machine); }
 
 // TOUCH EVENT FUNCTIONS PAGE 1 - RIGHT SIDE -----------------------------------
 
 void nex_zyl_800_zuluft_push_callback(void *ptr) {
-  zyl_800_zuluft.set(1);
-  nex_state_zyl_800_zuluft = !nex_state_zyl_800_zuluft;
+  touch_commands.post_state(command_set_valve, valve_800_zuluft, 1);
+  nextion_widgets.toggle_displayed_value(widget_zyl_800_zuluft);
 }
 void nex_zyl_800_zuluft_pop_callback(void *ptr) { //
-  zyl_800_zuluft.set(0);
+  touch_commands.post_state(command_set_valve, valve_800_zuluft, 0);
 }
 
 void nex_zyl_800_abluft_push_callback(void *ptr) {
-  zyl_800_abluft.toggle();
-  nex_state_zyl_800_abluft = !nex_state_zyl_800_abluft;
+  touch_commands.post(command_toggle_valve, valve_800_abluft);
+  nextion_widgets.toggle_displayed_value(widget_zyl_800_abluft);
 }
 
 void nex_zyl_startklemme_push_callback(void *ptr) {
-  zyl_startklemme.toggle();
-  nex_state_zyl_startklemme = !nex_state_zyl_startklemme;
+  touch_commands.post(command_toggle_valve, valve_startklemme);
+  nextion_widgets.toggle_displayed_value(widget_zyl_startklemme);
 }
 
 void nex_zyl_wippenhebel_push_callback(void *ptr) {
-  zyl_wippenhebel.toggle();
-  nex_state_zyl_wippenhebel = 1;
+  touch_commands.post(command_toggle_valve, valve_wippenhebel);
+  nextion_widgets.set_displayed_value(widget_zyl_wippenhebel, 1);
 }
 
 void nex_zyl_wippenhebel_pop_callback(void *ptr) { //
-  nex_state_zyl_wippenhebel = 0;
+  nextion_widgets.set_displayed_value(widget_zyl_wippenhebel, 0);
 }
 
-void nex_zyl_spanntaste_push_callback(void *ptr) { zyl_spanntaste.set(1); }
+void nex_zyl_spanntaste_push_callback(void *ptr) { touch_commands.post_state(command_set_valve, valve_spanntaste, 1); }
 
-void nex_zyl_spanntaste_pop_callback(void *ptr) { zyl_spanntaste.set(0); }
+void nex_zyl_spanntaste_pop_callback(void *ptr) { touch_commands.post_state(command_set_valve, valve_spanntaste, 0); }
 
-void nex_zyl_schweisstaste_push_callback(void *ptr) { zyl_schweisstaste.set(1); }
+void nex_zyl_schweisstaste_push_callback(void *ptr) {
+  touch_commands.post_state(command_set_valve, valve_schweisstaste, 1);
+}
 
-void nex_zyl_schweisstaste_pop_callback(void *ptr) { zyl_schweisstaste.set(0); }
+void nex_zyl_schweisstaste_pop_callback(void *ptr) {
+  touch_commands.post_state(command_set_valve, valve_schweisstaste, 0);
+}
 
-void nex_zyl_messer_push_callback(void *ptr) { zyl_block_messer.set(1); }
+void nex_zyl_messer_push_callback(void *ptr) { touch_commands.post_state(command_set_valve, valve_messer, 1); }
 
-void nex_zyl_messer_pop_callback(void *ptr) { zyl_block_messer.set(0); }
+void nex_zyl_messer_pop_callback(void *ptr) { touch_commands.post_state(command_set_valve, valve_messer, 0); }
 
-void nex_zyl_foerdern_push_callback(void *ptr) {
-  zyl_block_klemmrad.set(1);
-  zyl_block_foerdermotor.set(1);
-}
+void nex_zyl_foerdern_push_callback(void *ptr) { touch_commands.post_state(command_set_valve, valve_foerdern, 1); }
 
-void nex_zyl_foerdern_pop_callback(void *ptr) {
-  zyl_block_klemmrad.set(0);
-  zyl_block_foerdermotor.set(0);
-}
+void nex_zyl_foerdern_pop_callback(void *ptr) { touch_commands.post_state(command_set_valve, valve_foerdern, 0); }
 
 void nex_zyl_hauptluft_push_callback(void *ptr) {
-  zyl_hauptluft.toggle();
-  nex_state_zyl_hauptluft = !nex_state_zyl_hauptluft;
+  touch_commands.post(command_toggle_valve, valve_hauptluft);
+  nextion_widgets.toggle_displayed_value(widget_zyl_hauptluft);
 }
 
 // TOUCH EVENT FUNCTIONS PAGE 2 ------------------------------------------------
@@ -440,26 +558,63 @@ void increase_slider_value(int eeprom_value_number, long max_value, long interva
   }
 }
 
-void nex_button_1_left_push_callback(void *ptr) { decrease_slider_value(cycles_in_a_row, 0, 1); }
+void adjust_slider_value(int eeprom_value_number, long min_value, long max_value, long interval, bool increase) {
+  if (increase) {
+    increase_slider_value(eeprom_value_number, max_value, interval);
+  } else {
+    decrease_slider_value(eeprom_value_number, min_value, interval);
+  }
+}
+
+void adjust_setting(byte slider, bool increase) {
+  switch (slider) {
+  case slider_cycles_in_a_row:
+    adjust_slider_value(cycles_in_a_row, 0, 10, 1, increase);
+    break;
+  case slider_cooldown_time:
+    adjust_slider_value(long_cooldown_time, 0, 600, 5, increase);
+    break;
+  case slider_feed_time:
+    adjust_slider_value(strap_eject_feed_time, 0, 2000, 100, increase);
+    break;
+  case slider_startfuelldruck:
+    adjust_slider_value(startfuelldruck, 0, 3000, 100, increase);
+    break;
+  }
+}
+
+void nex_button_1_left_push_callback(void *ptr) {
+  touch_commands.post(command_adjust_setting, slider_cycles_in_a_row, 0);
+}
 
-void nex_button_1_right_push_callback(void *ptr) { increase_slider_value(cycles_in_a_row, 10, 1); }
+void nex_button_1_right_push_callback(void *ptr) {
+  touch_commands.post(command_adjust_setting, slider_cycles_in_a_row, 1);
+}
 
-void nex_button_2_left_push_callback(void *ptr) { decrease_slider_value(long_cooldown_time, 0, 5); }
+void nex_button_2_left_push_callback(void *ptr) {
+  touch_commands.post(command_adjust_setting, slider_cooldown_time, 0);
+}
 
-void nex_button_2_right_push_callback(void *ptr) { increase_slider_value(long_cooldown_time, 600, 5); }
+void nex_button_2_right_push_callback(void *ptr) {
+  touch_commands.post(command_adjust_setting, slider_cooldown_time, 1);
+}
 
-void nex_button_3_left_push_callback(void *ptr) { decrease_slider_value(strap_eject_feed_time, 0, 100); }
+void nex_button_3_left_push_callback(void *ptr) { touch_commands.post(command_adjust_setting, slider_feed_time, 0); }
 
-void nex_button_3_right_push_callback(void *ptr) { increase_slider_value(strap_eject_feed_time, 2000, 100); }
+void nex_button_3_right_push_callback(void *ptr) { touch_commands.post(command_adjust_setting, slider_feed_time, 1); }
 
-void nex_button_4_left_push_callback(void *ptr) { decrease_slider_value(startfuelldruck, 0, 100); }
+void nex_button_4_left_push_callback(void *ptr) {
+  touch_commands.post(command_adjust_setting, slider_startfuelldruck, 0);
+}
 
-void nex_button_4_right_push_callback(void *ptr) { increase_slider_value(startfuelldruck, 3000, 100); }
+void nex_button_4_right_push_callback(void *ptr) {
+  touch_commands.post(command_adjust_setting, slider_startfuelldruck, 1);
+}
 
 // TOUCH EVENT FUNCTIONS PAGE 3 ------------------------------------------------
 
 void nex_button_reset_shorttime_counter_push_callback(void *ptr) {
-  eeprom_counter.set_value(shorttime_counter, 0);
+  touch_commands.post(command_reset_shorttime_counter);
 
   // RESET LONGTIME COUNTER IF RESET BUTTON IS PRESSED LONG ENOUGH:
   // ACTIVATE TIMEOUT TO RESET LONGTIME COUNTER:
@@ -469,6 +624,98 @@ void nex_button_reset_shorttime_counter_push_callback(void *ptr) {
 
 void nex_button_reset_shorttime_counter_pop_callback(void *ptr) { timeout_reset_button.set_flag_activated(0); }
 
+// EXECUTE TOUCH COMMANDS ------------------------------------------------------
+
+void set_manual_valve(byte valve, bool state, bool toggle) {
+  Image_output *output = NULL;
+  switch (valve) {
+  case valve_800_zuluft:
+    output = &zyl_800_zuluft;
+    break;
+  case valve_800_abluft:
+    output = &zyl_800_abluft;
+    break;
+  case valve_startklemme:
+    output = &zyl_startklemme;
+    break;
+  case valve_wippenhebel:
+    output = &zyl_wippenhebel;
+    break;
+  case valve_spanntaste:
+    output = &zyl_spanntaste;
+    break;
+  case valve_schweisstaste:
+    output = &zyl_schweisstaste;
+    break;
+  case valve_messer:
+    output = &zyl_block_messer;
+    break;
+  case valve_foerdern:
+    zyl_block_klemmrad.set(state);
+    output = &zyl_block_foerdermotor;
+    break;
+  case valve_hauptluft:
+    output = &zyl_hauptluft;
+    break;
+  }
+  if (!output) {
+    return;
+  }
+  if (toggle) {
+    output->toggle();
+  } else {
+    output->set(state);
+  }
+}
+
+void execute_touch_command(Queued_command &command) {
+  switch (command.type) {
+  case command_toggle_machine_running:
+    state_controller.toggle_machine_running_state();
+    break;
+  case command_toggle_step_auto_mode:
+    state_controller.toggle_step_auto_mode();
+    break;
+  case command_step_back:
+  case command_step_next:
+    state_controller.set_machine_stop();
+    step_graph.cancel();
+    step_overlap.cancel();
+    reset_flag_of_current_step();
+    state_controller.set_step_mode();
+    if (command.type == command_step_back) {
+      state_controller.switch_to_previous_step();
+    } else {
+      state_controller.switch_to_next_step();
+    }
+    reset_flag_of_current_step();
+    error_message = no_error;
+    break;
+  case command_reset_machine:
+    reset_machine();
+    break;
+  case command_set_valve:
+    set_manual_valve(command.argument, command.state, false);
+    break;
+  case command_toggle_valve:
+    set_manual_valve(command.argument, 0, true);
+    break;
+  case command_adjust_setting:
+    adjust_setting(command.argument, command.state);
+    break;
+  case command_reset_shorttime_counter:
+    eeprom_counter.set_value(shorttime_counter, 0);
+    break;
+  }
+}
+
+void execute_touch_commands() {
+  Queued_command command;
+  while (touch_commands.read(command)) {
+    execute_touch_command(command);
+  }
+}
+
 // END OF NEXTION TOUCH EVENT FUNCTIONS ****************************************
 
 // NEXTION SETUP ***************************************************************
@@ -479,105 +726,100 @@ void nextion_setup() {
   // REGISTER EVENT CALLBACK FUNCTIONS -----------------------------------------
 
   // PAGE 0:
-  nex_page_0.attachPush(nex_page_0_push_callback);
+  nextion_touch_parser.attach_push(nex_page_0, nex_page_0_push_callback);
   // PAGE 1 - LEFT SIDE:
-  nex_page_1.attachPush(nex_page_1_push_callback);
-  nex_button_stepback.attachPush(nex_button_stepback_push_callback);
-  nex_button_stepnxt.attachPush(nex_button_stepnxt_push_callback);
-  nex_button_reset_machine.attachPush(nex_button_reset_machine_push_callback);
-  nex_button_stepback.attachPush(nex_button_stepback_push_callback);
-  nex_button_stepnxt.attachPush(nex_button_stepnxt_push_callback);
-  nex_button_mode.attachPush(nex_button_mode_push_callback);
-  nex_button_play_pause.attachPush(nex_button_play_pause_push_callback);
-  nex_button_play_pause.attachPop(nex_button_play_pause_pop_callback);
+  nextion_touch_parser.attach_push(nex_page_1, nex_page_1_push_callback);
+  nextion_touch_parser.attach_push(nex_button_stepback, nex_button_stepback_push_callback);
+  nextion_touch_parser.attach_push(nex_button_stepnxt, nex_button_stepnxt_push_callback);
+  nextion_touch_parser.attach_push(nex_button_reset_machine, nex_button_reset_machine_push_callback);
+  nextion_touch_parser.attach_push(nex_button_mode, nex_button_mode_push_callback);
+  nextion_touch_parser.attach_push(nex_button_play_pause, nex_button_play_pause_push_callback);
+  nextion_touch_parser.attach_pop(nex_button_play_pause, nex_button_play_pause_pop_callback);
   // PAGE 1 - RIGHT SIDE:
-  nex_zyl_startklemme.attachPush(nex_zyl_startklemme_push_callback);
-  nex_zyl_800_zuluft.attachPush(nex_zyl_800_zuluft_push_callback);
-  nex_zyl_800_zuluft.attachPop(nex_zyl_800_zuluft_pop_callback);
-  nex_zyl_800_abluft.attachPush(nex_zyl_800_abluft_push_callback);
-  nex_zyl_startklemme.attachPush(nex_zyl_startklemme_push_callback);
-  nex_zyl_wippenhebel.attachPush(nex_zyl_wippenhebel_push_callback);
-  nex_zyl_wippenhebel.attachPop(nex_zyl_wippenhebel_pop_callback);
-  nex_zyl_spanntaste.attachPush(nex_zyl_spanntaste_push_callback);
-  nex_zyl_spanntaste.attachPop(nex_zyl_spanntaste_pop_callback);
-  nex_zyl_schweisstaste.attachPush(nex_zyl_schweisstaste_push_callback);
-  nex_zyl_schweisstaste.attachPop(nex_zyl_schweisstaste_pop_callback);
-  nex_zyl_messer.attachPush(nex_zyl_messer_push_callback);
-  nex_zyl_messer.attachPop(nex_zyl_messer_pop_callback);
-  nex_zyl_foerdern.attachPush(nex_zyl_foerdern_push_callback);
-  nex_zyl_foerdern.attachPop(nex_zyl_foerdern_pop_callback);
-  nex_zyl_hauptluft.attachPush(nex_zyl_hauptluft_push_callback);
+  nextion_touch_parser.attach_push(nex_zyl_startklemme, nex_zyl_startklemme_push_callback);
+  nextion_touch_parser.attach_push(nex_zyl_800_zuluft, nex_zyl_800_zuluft_push_callback);
+  nextion_touch_parser.attach_pop(nex_zyl_800_zuluft, nex_zyl_800_zuluft_pop_callback);
+  nextion_touch_parser.attach_push(nex_zyl_800_abluft, nex_zyl_800_abluft_push_callback);
+  nextion_touch_parser.attach_push(nex_zyl_wippenhebel, nex_zyl_wippenhebel_push_callback);
+  nextion_touch_parser.attach_pop(nex_zyl_wippenhebel, nex_zyl_wippenhebel_pop_callback);
+  nextion_touch_parser.attach_push(nex_zyl_spanntaste, nex_zyl_spanntaste_push_callback);
+  nextion_touch_parser.attach_pop(nex_zyl_spanntaste, nex_zyl_spanntaste_pop_callback);
+  nextion_touch_parser.attach_push(nex_zyl_schweisstaste, nex_zyl_schweisstaste_push_callback);
+  nextion_touch_parser.attach_pop(nex_zyl_schweisstaste, nex_zyl_schweisstaste_pop_callback);
+  nextion_touch_parser.attach_push(nex_zyl_messer, nex_zyl_messer_push_callback);
+  nextion_touch_parser.attach_pop(nex_zyl_messer, nex_zyl_messer_pop_callback);
+  nextion_touch_parser.attach_push(nex_zyl_foerdern, nex_zyl_foerdern_push_callback);
+  nextion_touch_parser.attach_pop(nex_zyl_foerdern, nex_zyl_foerdern_pop_callback);
+  nextion_touch_parser.attach_push(nex_zyl_hauptluft, nex_zyl_hauptluft_push_callback);
   // PAGE 2:
-  nex_page_2.attachPush(nex_page_2_push_callback);
-  nex_button_1_left.attachPush(nex_button_1_left_push_callback);
-  nex_button_1_right.attachPush(nex_button_1_right_push_callback);
-  nex_button_2_left.attachPush(nex_button_2_left_push_callback);
-  nex_button_2_right.attachPush(nex_button_2_right_push_callback);
-  nex_button_3_left.attachPush(nex_button_3_left_push_callback);
-  nex_button_3_right.attachPush(nex_button_3_right_push_callback);
-  nex_button_4_left.attachPush(nex_button_4_left_push_callback);
-  nex_button_4_right.attachPush(nex_button_4_right_push_callback);
+  nextion_touch_parser.attach_push(nex_page_2, nex_page_2_push_callback);
+  nextion_touch_parser.attach_push(nex_button_1_left, nex_button_1_left_push_callback);
+  nextion_touch_parser.attach_push(nex_button_1_right, nex_button_1_right_push_callback);
+  nextion_touch_parser.attach_push(nex_button_2_left, nex_button_2_left_push_callback);
+  nextion_touch_parser.attach_push(nex_button_2_right, nex_button_2_right_push_callback);
+  nextion_touch_parser.attach_push(nex_button_3_left, nex_button_3_left_push_callback);
+  nextion_touch_parser.attach_push(nex_button_3_right, nex_button_3_right_push_callback);
+  nextion_touch_parser.attach_push(nex_button_4_left, nex_button_4_left_push_callback);
+  nextion_touch_parser.attach_push(nex_button_4_right, nex_button_4_right_push_callback);
 
   // PAGE 3:
-  nex_page_3.attachPush(nex_page_3_push_callback);
-  nex_button_reset_shorttime_counter.attachPush(nex_button_reset_shorttime_counter_push_callback);
-  nex_button_reset_shorttime_counter.attachPop(nex_button_reset_shorttime_counter_pop_callback);
+  nextion_touch_parser.attach_push(nex_page_3, nex_page_3_push_callback);
+  nextion_touch_parser.attach_push(nex_button_reset_shorttime_counter, //
+                                    nex_button_reset_shorttime_counter_push_callback);
+  nextion_touch_parser.attach_pop(nex_button_reset_shorttime_counter, nex_button_reset_shorttime_counter_pop_callback);
+
+  // PAGE 4:
+  nextion_touch_parser.attach_push(nex_page_4, nex_page_4_push_callback);
 
   // ---------------------------------------------------------------------------
 
   delay(3000); // Show start screen
-  sendCommand("page 1");
+  nextion_queue.begin_command();
+  nextion_queue.print(F("page 1"));
   send_to_nextion();
 
 } // END OF NEXTION SETUP
 
 // NEXTION GENERAL DISPLAY FUNCTIONS *******************************************
+// Commands are printed straight into the transmit queue, no String objects.
+// Texts and object names are stored in flash, use F("...") where possible.
 
-void send_to_nextion() {
-  Serial2.write(0xff);
-  Serial2.write(0xff);
-  Serial2.write(0xff);
-}
+// Every command starts with nextion_queue.begin_command() and is queued for
+// transmission by send_to_nextion(), false = dropped (queue full):
+bool send_to_nextion() { return nextion_queue.end_command(); }
 
 void show_info_field() {
   if (nex_current_page == 1) {
-    Serial2.print("vis t4,1");
+    nextion_queue.begin_command();
+    nextion_queue.print(F("vis t4,1"));
     send_to_nextion();
   }
 }
 
-String add_suffix_to_value(long value, String suffix) {
-  String value_string = String(value);
-  String space = " ";
-  String suffixed_string = value_string + space + suffix;
-  return suffixed_string;
-}
-
-void display_text_in_info_field(String text) {
+void hide_info_field() {
   if (nex_current_page == 1) {
-    Serial2.print("t4");
-    Serial2.print(".txt=");
-    Serial2.print("\"");
-    Serial2.print(text);
-    Serial2.print("\"");
+    nextion_queue.begin_command();
+    nextion_queue.print(F("vis t4,0"));
     send_to_nextion();
   }
 }
 
-void hide_info_field() {
-  if (nex_current_page == 1) {
-    Serial2.print("vis t4,0");
-    send_to_nextion();
-  }
+// A text can be printed in parts between begin_text_in_field() and
+// end_text_in_field():
+void begin_text_in_field(const char *text_field) {
+  nextion_queue.begin_command();
+  nextion_queue.print(text_field);
+  nextion_queue.print(F(".txt=\""));
 }
 
-void clear_text_field(String text_field) {
-  Serial2.print(text_field);
-  Serial2.print(".txt=");
-  Serial2.print("\"");
-  Serial2.print(""); // erase text
-  Serial2.print("\"");
-  send_to_nextion();
+bool end_text_in_field() {
+  nextion_queue.print(F("\""));
+  return send_to_nextion();
+}
+
+void clear_text_field(const char *text_field) {
+  begin_text_in_field(text_field);
+  end_text_in_field(); // erase text
 }
 
 void clear_info_field() {
@@ -586,60 +828,68 @@ void clear_info_field() {
   }
 }
 
-void display_value_in_field(int value, String value_field) {
-  Serial2.print(value_field);
-  Serial2.print(".val=");
-  Serial2.print(value);
+void display_value_in_field(int value, const char *value_field) {
+  nextion_queue.begin_command();
+  nextion_queue.print(value_field);
+  nextion_queue.print(F(".val="));
+  nextion_queue.print(long(value));
   send_to_nextion();
 }
 
-void display_text_in_field(String text, String text_field) {
-  Serial2.print(text_field);
-  Serial2.print(".txt=");
-  Serial2.print("\"");
-  Serial2.print(text);
-  Serial2.print("\"");
-  send_to_nextion();
+void display_text_in_field(const __FlashStringHelper *text, const char *text_field) {
+  begin_text_in_field(text_field);
+  nextion_queue.print(text);
+  end_text_in_field();
 }
 
-void toggle_ds_switch(String button) {
-  Serial2.print("click " + button + ",1");
-  send_to_nextion();
+bool display_suffixed_value_in_field(long value, const __FlashStringHelper *suffix, const char *text_field) {
+  begin_text_in_field(text_field);
+  nextion_queue.print(value);
+  nextion_queue.print(F(" "));
+  nextion_queue.print(suffix);
+  return end_text_in_field();
 }
 
-void set_momentary_button_high_or_low(String button, bool state) {
-  Serial2.print("click " + button + "," + state);
-  send_to_nextion();
+bool toggle_ds_switch(const char *button) {
+  nextion_queue.begin_command();
+  nextion_queue.print(F("click "));
+  nextion_queue.print(button);
+  nextion_queue.print(F(",1"));
+  return send_to_nextion();
 }
 
-// NEXTION DISPLAY LOOPS *******************************************************
+bool set_momentary_button_high_or_low(const char *button, bool state) {
+  nextion_queue.begin_command();
+  nextion_queue.print(F("click "));
+  nextion_queue.print(button);
+  nextion_queue.print(state ? F(",1") : F(",0"));
+  return send_to_nextion();
+}
 
-// DISPLAY LOOP PAGE 1 LEFT SIDE: ----------------------------------------------
+// NEXTION DISPLAY ITEMS *******************************************************
 
-void display_pic_in_field(String picture, String textField) {
-  Serial2.print(textField);
-  Serial2.print(".pic=");
-  Serial2.print(picture);
-  send_to_nextion();
+bool display_pic_in_field(int picture, const char *textField) {
+  nextion_queue.begin_command();
+  nextion_queue.print(textField);
+  nextion_queue.print(F(".pic="));
+  nextion_queue.print(long(picture));
+  if (!send_to_nextion()) {
+    return false;
+  }
   // 2nd picture for buttons:
-  Serial2.print(textField);
-  Serial2.print(".pic2=");
-  Serial2.print(picture);
-  send_to_nextion();
+  nextion_queue.begin_command();
+  nextion_queue.print(textField);
+  nextion_queue.print(F(".pic2="));
+  nextion_queue.print(long(picture));
+  return send_to_nextion();
 }
 
+// SPINNER AND TACHO: ----------------------------------------------------------
+
 void reset_spinner_picture() { //
   current_spinner_pos = 0;
 }
 
-void update_spinner_picture() {
-  if (nex_current_spinner_pos != current_spinner_pos) {
-    String picture = String(spinner_pics_array[current_spinner_pos]);
-    display_pic_in_field(picture, "spinner");
-    nex_current_spinner_pos = current_spinner_pos;
-  }
-}
-
 void select_next_spinner_pic() {
   int number_of_spinner_pics = sizeof(spinner_pics_array) / sizeof(int);
   int max_spinner_pic_pos = number_of_spinner_pics - 1;
@@ -659,21 +909,14 @@ void run_spinner() {
   }
 }
 
-void update_tacho_picture() {
-  if (nex_current_tacho_pos != current_tacho_pos) {
-    String picture = String(tacho_pics_array[current_tacho_pos]);
-    display_pic_in_field(picture, "force");
-    nex_current_tacho_pos = current_tacho_pos;
-  }
-}
-
 int get_tacho_pos_from_pressure() {
 
   int number_of_tacho_pics = sizeof(tacho_pics_array) / sizeof(int);
   int max_tacho_pic_number = number_of_tacho_pics - 1;
 
-  float force_fraction = float(force_int) / max_tool_force;
-  int array_position = int(round(force_fraction * float(max_tacho_pic_number)));
+  // Rounded force fraction:
+  long scaled_force = long(force_int) * max_tacho_pic_number;
+  int array_position = (scaled_force + max_tool_force / 2) / max_tool_force;
 
   if (array_position >= max_tacho_pic_number) {
     array_position = max_tacho_pic_number;
@@ -682,241 +925,173 @@ int get_tacho_pos_from_pressure() {
   return array_position;
 }
 
-void run_tacho() { //
-  current_tacho_pos = get_tacho_pos_from_pressure();
-};
-
-String get_main_cycle_display_string() {
+const __FlashStringHelper *get_main_cycle_display_string() {
   int current_step = state_controller.get_current_step();
-  String display_text_cycle_name = main_cycle_steps[current_step]->get_display_text();
-  return display_text_cycle_name;
-}
-
-void update_cycle_name() {
-  if (nex_state_cycle_step != state_controller.get_current_step()) {
-    String number = String(state_controller.get_current_step() + 1);
-    String name = get_main_cycle_display_string();
-    Serial.println(number + " " + name);
-    display_text_in_field(number + " " + name, "t0");
-    nex_state_cycle_step = state_controller.get_current_step();
-  }
-}
-
-void update_button_play_pause() {
-  if (nex_state_machine_running != state_controller.machine_is_running()) {
-    toggle_ds_switch("play");
-    nex_state_machine_running = state_controller.machine_is_running();
+  return cycle_steps.get_display_text(current_step);
+}
+
+const __FlashStringHelper *get_error_text(long error_number) {
+  switch (error_number) {
+  case error_kein_band:
+    return F("KEIN BAND");
+  case error_stopped:
+    return F("STOPPED");
+  case error_run_reset:
+    return F("RUN RESET ");
+  case error_step_timeout:
+    return F("TIMEOUT STEP ");
+  case error_valve_schedule:
+    return F("VALVE QUEUE FULL");
+  default:
+    return F("");
   }
 }
 
-void update_button_step_auto() {
-  if (nex_state_step_mode != state_controller.is_in_step_mode()) {
-    toggle_ds_switch("bt1");
-    nex_state_step_mode = state_controller.is_in_step_mode();
-  }
-}
+// WIDGET VALUES: --------------------------------------------------------------
 
-void update_force_display() {
-  if (nex_state_force_int != force_int) {
-    String suffixed_value = add_suffix_to_value(force_int, "N");
-    display_text_in_field(suffixed_value, "t2");
-    nex_state_force_int = force_int;
-  }
-}
+long get_spinner_pos() { return current_spinner_pos; }
+long get_tacho_pos() { return get_tacho_pos_from_pressure(); }
+long get_force() { return force_int; }
+long get_current_step() { return state_controller.get_current_step(); }
+long get_machine_running() { return state_controller.machine_is_running(); }
+long get_step_mode() { return state_controller.is_in_step_mode(); }
 
-void show_error() {
-  if (nex_state_error_message != error_message) {
-    display_text_in_info_field(error_message);
+// Negative values are error messages, positive values the pause time left:
+long get_info() {
+  if (error_message != no_error) {
+    return -error_message;
   }
-  nex_state_error_message = error_message;
-}
-
-void show_remaining_pause_time() {
   long restpausenzeit = timeout_long_pause.get_remaining_timeout_time() / 1000;
-
-  if (nex_state_restpausenzeit != restpausenzeit) {
-    if (restpausenzeit > 0 && restpausenzeit < 1000) {
-      String pause = "PAUSE: ";
-      String zeit = add_suffix_to_value(restpausenzeit, "s");
-      String displaystring = pause + zeit;
-      display_text_in_info_field(displaystring);
-      nex_state_restpausenzeit = restpausenzeit;
-    }
+  if (restpausenzeit > 0 && restpausenzeit < 1000) {
+    return restpausenzeit;
   }
+  return 0;
 }
 
-void display_loop_page_1_left_side() {
-
-  run_spinner();
-  update_spinner_picture();
-
-  if (delay_tacho_update.delay_time_is_up(200)) {
-    run_tacho();
-    update_tacho_picture();
-    update_force_display();
-  }
-
-  update_cycle_name();
+long get_zyl_800_zuluft() { return zyl_800_zuluft.get_state(); }
+long get_zyl_800_abluft() { return zyl_800_abluft.get_state(); }
+long get_zyl_startklemme() { return zyl_startklemme.get_state(); }
+long get_zyl_wippenhebel() { return zyl_wippenhebel.get_state(); }
+long get_zyl_spanntaste() { return zyl_spanntaste.get_state(); }
+long get_zyl_messer() { return zyl_block_messer.get_state(); }
+long get_zyl_foerdern() { return zyl_block_foerdermotor.get_state(); }
+long get_zyl_schweisstaste() { return zyl_schweisstaste.get_state(); }
+long get_zyl_hauptluft() { return zyl_hauptluft.get_state(); }
 
-  update_button_play_pause();
+long get_cycles_in_a_row() { return eeprom_counter.get_value(cycles_in_a_row); }
+long get_cooldown_time() { return eeprom_counter.get_value(long_cooldown_time); }
+long get_feed_time() { return eeprom_counter.get_value(strap_eject_feed_time); }
+long get_startfuelldruck() { return eeprom_counter.get_value(startfuelldruck); }
+long get_pressure() { return (pressure_mbar + 50) / 100; } // [0.1bar]
 
-  update_button_step_auto();
+long get_shorttime_counter() { return eeprom_counter.get_value(shorttime_counter); }
+long get_longtime_counter() { return eeprom_counter.get_value(longtime_counter); }
 
-  show_error();
+// WIDGET FORMATTERS: ----------------------------------------------------------
 
-  show_remaining_pause_time();
+bool send_spinner_picture(const char *object, long value) {
+  return display_pic_in_field(spinner_pics_array[value], object);
 }
 
-// DISPLAY LOOP PAGE 1 RIGHT SIDE: ---------------------------------------------
-
-void update_button_zuluft_800() {
-  if (zyl_800_zuluft.get_state() != nex_state_zyl_800_zuluft) {
-    toggle_ds_switch("bt5");
-    nex_state_zyl_800_zuluft = !nex_state_zyl_800_zuluft;
-  }
+bool send_tacho_picture(const char *object, long value) {
+  return display_pic_in_field(tacho_pics_array[value], object);
 }
 
-void update_button_abluft_800() {
-  if (zyl_800_abluft.get_state() != nex_state_zyl_800_abluft) {
-    toggle_ds_switch("bt4");
-    nex_state_zyl_800_abluft = !nex_state_zyl_800_abluft;
+bool send_cycle_name(const char *object, long value) {
+  const __FlashStringHelper *name = get_main_cycle_display_string();
+  begin_text_in_field(object);
+  nextion_queue.print(value + 1);
+  nextion_queue.print(F(" "));
+  nextion_queue.print(name);
+  if (!end_text_in_field()) {
+    return false;
   }
-}
-
-void update_button_klemmblock() {
-  if (zyl_startklemme.get_state() != nex_state_zyl_startklemme) {
-    toggle_ds_switch("bt3");
-    nex_state_zyl_startklemme = !nex_state_zyl_startklemme;
-  }
-}
-
-void update_button_wippenhebel() {
-  if (zyl_wippenhebel.get_state() != nex_state_zyl_wippenhebel) {
-    bool state = zyl_wippenhebel.get_state();
-    set_momentary_button_high_or_low("b5", state);
-    nex_state_zyl_wippenhebel = state;
-  }
-}
-
-void update_button_spanntaste() {
-  if (zyl_spanntaste.get_state() != nex_state_zyl_spanntaste) {
-    bool state = zyl_spanntaste.get_state();
-    set_momentary_button_high_or_low("b4", state);
-    nex_state_zyl_spanntaste = state;
-  }
-}
-
-void update_button_messer() {
-  if (zyl_block_messer.get_state() != nex_state_zyl_messer) {
-    bool state = zyl_block_messer.get_state();
-    set_momentary_button_high_or_low("b6", state);
-    nex_state_zyl_messer = state;
-  }
-}
-
-void update_button_foerdern() {
-  bool state = zyl_block_foerdermotor.get_state();
-  if (state != nex_state_zyl_foerdern) {
-    set_momentary_button_high_or_low("b7", state);
-    nex_state_zyl_foerdern = state;
+  Serial.print(value + 1);
+  Serial.print(F(" "));
+  Serial.println(name);
+  return true;
+}
+
+bool send_info(const char *object, long value) {
+  begin_text_in_field(object);
+  if (value < 0) {
+    nextion_queue.print(get_error_text(-value));
+    if (-value == error_run_reset) {
+      nextion_queue.print(long(timeout_count));
+    }
+    if (-value == error_step_timeout) {
+      nextion_queue.print(long(step_watchdog.get_fault_step() + 1));
+    }
+  } else if (value > 0) {
+    nextion_queue.print(F("PAUSE: "));
+    nextion_queue.print(value);
+    nextion_queue.print(F(" s"));
   }
+  return end_text_in_field();
 }
 
-void update_button_schweissen() {
-  if (zyl_schweisstaste.get_state() != nex_state_zyl_schweisstaste) {
-    bool state = zyl_schweisstaste.get_state();
-    set_momentary_button_high_or_low("b3", state);
-    nex_state_zyl_schweisstaste = state;
-  }
-}
+bool send_dualstate(const char *object, long value) { return toggle_ds_switch(object); }
 
-void update_button_hauptluft() {
-  if (zyl_hauptluft.get_state() != nex_state_zyl_hauptluft) {
-    toggle_ds_switch("bt6");
-    nex_state_zyl_hauptluft = zyl_hauptluft.get_state();
-  }
-}
+bool send_momentary(const char *object, long value) { return set_momentary_button_high_or_low(object, value); }
 
-void display_loop_page_1_right_side() {
-  update_button_zuluft_800();
-  update_button_abluft_800();
-  update_button_klemmblock();
-  update_button_wippenhebel();
-  update_button_spanntaste();
-  update_button_messer();
-  update_button_foerdern();
-  update_button_schweissen();
-  update_button_hauptluft();
+bool send_number(const char *object, long value) {
+  begin_text_in_field(object);
+  nextion_queue.print(value);
+  return end_text_in_field();
 }
 
-// DIPLAY LOOP PAGE 2: ---------------------------------------------------------
+bool send_newton(const char *object, long value) { return display_suffixed_value_in_field(value, F("N"), object); }
 
-void update_number_of_cycles() {
-  long value = eeprom_counter.get_value(cycles_in_a_row);
-  if (nex_state_cycles_in_a_row != value) {
-    String text = String(value);
-    display_text_in_field(text, "t4");
-    nex_state_cycles_in_a_row = value;
-  }
-}
-
-void update_cooldown_time() {
-  long value = eeprom_counter.get_value(long_cooldown_time);
-  if (nex_state_long_cooldown_time != value) {
-    String text = add_suffix_to_value(value, "s");
-    display_text_in_field(text, "t5");
-    nex_state_long_cooldown_time = value;
-  }
-}
+bool send_seconds(const char *object, long value) { return display_suffixed_value_in_field(value, F("s"), object); }
 
-void update_strap_feed_time() {
-  long value = eeprom_counter.get_value(strap_eject_feed_time);
-  if (nex_state_feed_time != value) {
-    String text = add_suffix_to_value(value, "ms");
-    display_text_in_field(text, "t7");
-    nex_state_feed_time = value;
-  }
+bool send_milliseconds(const char *object, long value) {
+  return display_suffixed_value_in_field(value, F("ms"), object);
 }
 
-void update_startfuelldruck() {
-  if (nex_state_startfuelldruck != eeprom_counter.get_value(startfuelldruck)) {
-    int value = eeprom_counter.get_value(startfuelldruck);
-    String display_string = add_suffix_to_value(value, "N");
-    display_text_in_field(display_string, "t9");
-    nex_state_startfuelldruck = eeprom_counter.get_value(startfuelldruck);
-  }
-}
-void update_pressure_display() {
-  Serial2.print("t10.txt=");
-  Serial2.print("\"");
-  Serial2.print(pressure_float, 1);
-  Serial2.print(" bar");
-  Serial2.print("\"");
-  send_to_nextion();
-  nex_state_federdruck = pressure_float;
+bool send_pressure(const char *object, long value) {
+  begin_text_in_field(object);
+  nextion_queue.print_fixed(value, 1);
+  nextion_queue.print(F(" bar"));
+  return end_text_in_field();
 }
 
-void display_loop_page_2() {
-  update_number_of_cycles();
-  update_cooldown_time();
-  update_strap_feed_time();
-  update_startfuelldruck();
+// WIDGET TABLE: ---------------------------------------------------------------
+// {page, object, value, formatter, min. interval [ms], keeps state, default}
+// Keeps state: dualstate and momentary buttons show their default value after a
+// page change and are only sent if the value differs.
 
-  if (delay_force_update.delay_time_is_up(200)) {
-    update_pressure_display();
-  }
-}
+const Nextion_widget nextion_widget_table[end_of_widget_enum] PROGMEM = {
+    // PAGE 1 - LEFT SIDE:
+    {1, "spinner", get_spinner_pos, send_spinner_picture, 0, true, 1},
+    {1, "force", get_tacho_pos, send_tacho_picture, 200, true, 0},
+    {1, "t2", get_force, send_newton, 200, false, 0},
+    {1, "t0", get_current_step, send_cycle_name, 0, false, 0},
+    {1, "play", get_machine_running, send_dualstate, 0, true, 0},
+    {1, "bt1", get_step_mode, send_dualstate, 0, true, 1},
+    {1, "t4", get_info, send_info, 0, false, 0},
+    // PAGE 1 - RIGHT SIDE:
+    {1, "bt5", get_zyl_800_zuluft, send_dualstate, 0, true, 0},
+    {1, "bt4", get_zyl_800_abluft, send_dualstate, 0, true, 1}, // INVERTED VALVE LOGIC
+    {1, "bt3", get_zyl_startklemme, send_dualstate, 0, true, 0},
+    {1, "b5", get_zyl_wippenhebel, send_momentary, 0, true, 0},
+    {1, "b4", get_zyl_spanntaste, send_momentary, 0, true, 0},
+    {1, "b6", get_zyl_messer, send_momentary, 0, true, 0},
+    {1, "b7", get_zyl_foerdern, send_momentary, 0, true, 0},
+    {1, "b3", get_zyl_schweisstaste, send_momentary, 0, true, 0},
+    {1, "bt6", get_zyl_hauptluft, send_dualstate, 0, true, 0},
+    // PAGE 2:
+    {2, "t4", get_cycles_in_a_row, send_number, 0, false, 0},
+    {2, "t5", get_cooldown_time, send_seconds, 0, false, 0},
+    {2, "t7", get_feed_time, send_milliseconds, 0, false, 0},
+    {2, "t9", get_startfuelldruck, send_newton, 0, false, 0},
+    {2, "t10", get_pressure, send_pressure, 200, false, 0},
+    // PAGE 3:
+    {3, "t12", get_shorttime_counter, send_number, 0, false, 0},
+    {3, "t10", get_longtime_counter, send_number, 0, false, 0},
+};
 
 // DIPLAY LOOP PAGE 3: ---------------------------------------------------------
 
-void update_longtime_counter_value() {
-  long value = eeprom_counter.get_value(shorttime_counter);
-  if (nex_state_shorttime_counter != value) {
-    display_text_in_field(String(value), "t12");
-    nex_state_shorttime_counter = value;
-  }
-}
-
 void reset_longtime_counter_value() {
   if (timeout_reset_button.is_marked_activated()) {
     if (timeout_reset_button.has_timed_out()) {
@@ -925,137 +1100,80 @@ void reset_longtime_counter_value() {
   }
 }
 
-void update_shorttime_counter_value() {
-  long value = eeprom_counter.get_value(longtime_counter);
-  if (nex_state_longtime_counter != value) {
-    display_text_in_field(String(value), "t10");
-    nex_state_longtime_counter = value;
-  }
-}
-
-void display_loop_page_3() {
+// DIPLAY LOOP PAGE 4: ---------------------------------------------------------
 
-  update_longtime_counter_value();
-  reset_longtime_counter_value();
-  update_shorttime_counter_value();
+// Sends one step per call as "min mean max last" [ms], the rows take turns:
+void update_step_statistics_page() {
+  static byte row = 0;
+  if (!delay_statistics_row.delay_time_is_up(100)) {
+    return;
+  }
+  Step_profiler &profiler = cycle_steps.get_profiler();
+  nextion_queue.begin_command();
+  nextion_queue.print(F("t"));
+  nextion_queue.print(long(row));
+  nextion_queue.print(F(".txt=\""));
+  nextion_queue.print(long(profiler.get_min_duration(row)));
+  nextion_queue.print(F(" "));
+  nextion_queue.print(long(profiler.get_mean_duration(row)));
+  nextion_queue.print(F(" "));
+  nextion_queue.print(long(profiler.get_max_duration(row)));
+  nextion_queue.print(F(" "));
+  nextion_queue.print(long(profiler.get_last_duration(row)));
+  end_text_in_field();
+
+  row++;
+  if (row >= cycle_steps.get_number_of_steps()) {
+    row = 0;
+  }
 }
 
 // NEXTION MAIN LOOP: ----------------------------------------------------------
 
 void nextion_loop() {
 
-  nexLoop(nex_listen_list); // check for any touch event
+  nextion_touch_parser.read_events(); // check for any touch event
 
   // PAGE 1 --------------------------------------
   if (nex_current_page == 1) // START PAGE 1
   {
-    display_loop_page_1_left_side();
-    display_loop_page_1_right_side();
-  }
-  // PAGE 2 --------------------------------------
-  if (nex_current_page == 2) // START PAGE 2
-  {
-    display_loop_page_2();
+    run_spinner();
   }
 
   // PAGE 3 --------------------------------------
   if (nex_current_page == 3) { // START PAGE 3
-    display_loop_page_3();
-  }
-
-} // END OF NEXTION MAIN LOOP
-
-// PROCESS PRESSURE SENSOR -----------------------------------------------------
-
-float get_pressure_from_sensor() {
-  // DRUCKSENSOR 0-10V => 0-12bar
-  // CONTROLLINO ANALOG INPUT VALUE 0-1023, 30mV per digit (controlino.biz)
-  // 10V   => analogRead 333.3 (10V/30mV)
-  // 12bar => anlaogRead 333.3
-  // 1bar  => analogRead 27.778
-  return analogRead(DRUCKSENSOR) / 27.778; //[bar]
-}
-
-float smoothe_measurement(float pressure_float) {
-  static float pressure_float_smoothed;
-  pressure_float_smoothed = ((pressure_float_smoothed * 4 + pressure_float) / 5);
-  return pressure_float_smoothed;
-}
-
-float calm_measurement(float pressure_float) {
-  // To prevent flickering, the pressure value will only be updated
-  // if there's a higher or lower value five times in a row.
-  // A positive calmcounter indicates rising pressure.
-  // A negative calmcounter indicates dropping pressure.
-
-  static float calmcounter;
-  static float pressure_sum;
-  static float pressure_calmed;
-  static float prev_pressure_calmed;
-
-  // Pressure seems to rise:
-  if (pressure_float > pressure_calmed) {
-    if (calmcounter >= 0) {
-      calmcounter++;
-      pressure_sum += pressure_float;
-    }
-    if (calmcounter < 0) // Pressure seemed to drop last time, reset calmcounter
-    {
-      calmcounter = 0;
-      pressure_sum = 0;
-    }
-  }
-  // Pressure seems to fall:
-  if (pressure_float < pressure_calmed) {
-    if (calmcounter <= 0) {
-      calmcounter--;
-      pressure_sum += pressure_float;
-    }
-    if (calmcounter > 0) // Pressure seemed to rise last time, reset calmcounter
-    {
-      calmcounter = 0;
-      pressure_sum = 0;
-    }
+    reset_longtime_counter_value();
   }
 
-  if (fabs(calmcounter) >= 5) //
-  {
-    static float min_difference = 0.00; // [bar]
-    // Update value only if there is a significant difference to the previous
-    // value:
-    if (fabs(pressure_sum / fabs(calmcounter) - prev_pressure_calmed) > min_difference) {
-      pressure_calmed = pressure_sum / fabs(calmcounter);
-      prev_pressure_calmed = pressure_calmed;
-    }
-    calmcounter = 0;
-    pressure_sum = 0;
+  // PAGE 4 --------------------------------------
+  if (nex_current_page == 4) { // STATISTICS PAGE
+    update_step_statistics_page();
   }
-  return pressure_calmed;
-}
 
-int convert_pressure_to_force(float pressure) {
+  nextion_widgets.update(nex_current_page); // send what has changed
 
-  // Calculate force:
-  int force = pressure * 1472.6; // 1bar  => 1472.6N (Dauertest BXT 3-32 Zylinderkraft.xlsx)
+  nextion_queue.transmit(); // hand over what the serial buffer can take
 
-  // Set last digit zero:
-  force = force / 10;
-  force = force * 10;
+} // END OF NEXTION MAIN LOOP
 
-  return force;
-}
+// PROCESS PRESSURE SENSOR -----------------------------------------------------
 
 void read_and_process_pressure() {
-  pressure_float = get_pressure_from_sensor(); //[bar]
-  pressure_float = smoothe_measurement(pressure_float); //[bar]
-  pressure_float = calm_measurement(pressure_float);
-  force_int = convert_pressure_to_force(pressure_float); // [N]
+  // Process all samples taken since the last loop:
+  unsigned int adc_sum;
+  while (pressure_sampler.read_sample(adc_sum)) {
+    pressure_filter.add_oversampled_sample(adc_sum, PRESSURE_OVERSAMPLING_SHIFT);
+    vent_detector.add_sample(adc_sum);
+  }
+  pressure_mbar = pressure_filter.get_pressure_mbar();
+  force_int = pressure_filter.get_force(); // [N]
 }
 
 // CREATE CYCLE STEP CLASSES ***************************************************
 // -----------------------------------------------------------------------------
-class Aufwecken : public Cycle_step {
-  String get_display_text() { return "WIPPE ZIEHEN"; }
+class Aufwecken {
+public:
+  const __FlashStringHelper *get_display_text() { return F("WIPPE ZIEHEN"); }
 
   void do_initial_stuff() {
     delay_cycle_step.set_unstarted();
@@ -1068,8 +1186,9 @@ class Aufwecken : public Cycle_step {
   }
 };
 // -----------------------------------------------------------------------------
-class Vorschieben : public Cycle_step {
-  String get_display_text() { return "VORSCHIEBEN"; }
+class Vorschieben {
+public:
+  const __FlashStringHelper *get_display_text() { return F("VORSCHIEBEN"); }
   long feed_time;
 
   void do_initial_stuff() {
@@ -1089,21 +1208,21 @@ class Vorschieben : public Cycle_step {
   };
 };
 // -----------------------------------------------------------------------------
-class Schneiden : public Cycle_step {
-  String get_display_text() { return "SCHNEIDEN"; }
+class Schneiden {
+public:
+  const __FlashStringHelper *get_display_text() { return F("SCHNEIDEN"); }
 
-  void do_initial_stuff(){};
+  void do_initial_stuff() { start_stroke(stroke_messer, 1300, 500); };
   void do_loop_stuff() {
-    zyl_block_messer.stroke(1300, 500);
-
-    if (zyl_block_messer.stroke_completed()) {
+    if (stroke_messer.is_completed()) {
       set_loop_completed();
     }
   };
 };
 // -----------------------------------------------------------------------------
-class Stirzel : public Cycle_step {
-  String get_display_text() { return "STIRZEL"; }
+class Stirzel {
+public:
+  const __FlashStringHelper *get_display_text() { return F("STIRZEL"); }
 
   void do_initial_stuff() {
     zyl_block_klemmrad.set(1);
@@ -1118,8 +1237,9 @@ class Stirzel : public Cycle_step {
   };
 };
 // -----------------------------------------------------------------------------
-class Festklemmen : public Cycle_step {
-  String get_display_text() { return "FESTKLEMMEN"; }
+class Festklemmen {
+public:
+  const __FlashStringHelper *get_display_text() { return F("FESTKLEMMEN"); }
 
   void do_initial_stuff() {
     zyl_startklemme.set(1);
@@ -1133,10 +1253,11 @@ class Festklemmen : public Cycle_step {
   };
 };
 // -----------------------------------------------------------------------------
-class Startdruck : public Cycle_step {
-  String get_display_text() { return "STARTDRUCK"; }
+class Startdruck {
+public:
+  const __FlashStringHelper *get_display_text() { return F("STARTDRUCK"); }
   byte is_full_counter = 0;
-  int minimum_inflation = 60; // [N]
+  bool is_pulsing;
 
   void do_initial_stuff() {
     zyl_block_klemmrad.set(0);
@@ -1144,13 +1265,32 @@ class Startdruck : public Cycle_step {
     delay_minimum_filltime.set_unstarted();
     delay_minimum_waittime.set_unstarted();
     is_full_counter = 0;
+    is_pulsing = false;
+    if (startdruck_parameters.is_adaptive) {
+      pneumatic_spring_block(); // the pulses open the zuluft only
+      fill_controller.start(eeprom_counter.get_value(startfuelldruck), startdruck_parameters.minimum_inflation);
+    }
   };
 
   void do_loop_stuff() {
+    byte confirmations = startdruck_parameters.confirmations;
+    if (startdruck_parameters.is_adaptive && !fill_controller.has_failed()) {
+      fill_with_adaptive_pulses();
+      confirmations = startdruck_parameters.adaptive_confirmations;
+    } else {
+      fill_with_fixed_pulses();
+    }
 
+    if (is_full_counter >= confirmations) {
+      pneumatic_spring_block();
+      set_loop_completed();
+    };
+  };
+
+  void fill_with_fixed_pulses() {
     // Build pressure after minmum wait time
-    if (force_int + minimum_inflation <= eeprom_counter.get_value(startfuelldruck)) {
-      if (delay_minimum_waittime.delay_time_is_up(250)) {
+    if (force_int + startdruck_parameters.minimum_inflation <= eeprom_counter.get_value(startfuelldruck)) {
+      if (delay_minimum_waittime.delay_time_is_up(startdruck_parameters.wait_time)) {
         pneumatic_spring_build_pressure();
         delay_minimum_filltime.reset_time();
         is_full_counter = 0;
@@ -1158,35 +1298,57 @@ class Startdruck : public Cycle_step {
     }
     // Stop building pressure after minmum filltime
     else {
-      if (delay_minimum_filltime.delay_time_is_up(90)) {
+      if (delay_minimum_filltime.delay_time_is_up(startdruck_parameters.fill_time)) {
         pneumatic_spring_block();
         delay_minimum_waittime.reset_time();
         is_full_counter++;
       }
     }
+  }
 
-    if (is_full_counter >= 14) {
-      pneumatic_spring_block();
-      set_loop_completed();
-    };
-  };
+  // Every decision is taken on a settled force, after a pulse or a wait:
+  void fill_with_adaptive_pulses() {
+    if (is_pulsing) {
+      if (!stroke_800_fuellen.is_completed()) {
+        return; // pulse and settle time
+      }
+      is_pulsing = false;
+      fill_controller.learn(force_int);
+    } else if (!delay_minimum_waittime.delay_time_is_up(startdruck_parameters.settle_time)) {
+      return;
+    }
+
+    unsigned int pulse = fill_controller.get_next_pulse(force_int);
+    if (pulse > 0) {
+      is_full_counter = 0;
+      start_stroke(stroke_800_fuellen, pulse, startdruck_parameters.settle_time);
+      is_pulsing = true;
+    } else if (!fill_controller.has_failed()) {
+      is_full_counter++;
+    }
+  }
 };
 // -----------------------------------------------------------------------------
-class Spannen : public Cycle_step {
-  String get_display_text() { return "SPANNEN"; }
+class Spannen {
+public:
+  const __FlashStringHelper *get_display_text() { return F("SPANNEN"); }
+  unsigned long release_margin = 200000; // [us] after the endposition is reached
+  Edge_event first_contact;
+  bool endposition_is_reached;
 
   void do_initial_stuff() {
     pneumatic_spring_block();
     zyl_spanntaste.set(1); // Spanntaste betätigen
     zyl_block_klemmrad.set(0);
-    delay_cycle_step.set_unstarted();
+    start_watching_switch(taster_endposition, first_contact, endposition_is_reached);
   };
   void do_loop_stuff() {
     if (is_in_display_debug_mode) {
       set_loop_completed();
     };
-    if (taster_endposition.get_raw_button_state()) {
-      if (delay_cycle_step.delay_time_is_up(200)) {
+    read_switch_edges(taster_endposition, first_contact, endposition_is_reached);
+    if (endposition_is_reached && taster_endposition.get_state()) {
+      if (micros() - first_contact.time >= release_margin) {
         zyl_spanntaste.set(0);
         set_loop_completed();
       }
@@ -1194,8 +1356,9 @@ class Spannen : public Cycle_step {
   };
 };
 // -----------------------------------------------------------------------------
-class Pause : public Cycle_step {
-  String get_display_text() { return "PAUSE"; }
+class Pause {
+public:
+  const __FlashStringHelper *get_display_text() { return F("PAUSE"); }
 
   void do_initial_stuff() { delay_cycle_step.set_unstarted(); };
   void do_loop_stuff() {
@@ -1205,57 +1368,82 @@ class Pause : public Cycle_step {
   };
 };
 // -----------------------------------------------------------------------------
-class Schweissen : public Cycle_step {
-  String get_display_text() { return "SCHWEISSEN"; }
+class Schweissen {
+public:
+  const __FlashStringHelper *get_display_text() { return F("SCHWEISSEN"); }
+
+  static const unsigned int push_time = 800; // [ms]
+  static const unsigned int release_time = 7000; // [ms] ceiling of the weld
 
   void do_initial_stuff() {
     zyl_spanntaste.set(0);
     pneumatic_spring_vent();
+    start_stroke(stroke_schweisstaste, push_time, release_time); // SCHWEISSSTART BIS ABKUEHLEN MAX. CA. 4s
+    weld_detector.start();
   };
 
   void do_loop_stuff() {
-    zyl_schweisstaste.stroke(800, 7000); // SCHWEISSSTART BIS ABKUEHLEN MAX. CA. 4s
-
-    if (zyl_schweisstaste.stroke_completed()) {
+    if (stroke_schweisstaste.is_completed()) {
+      weld_detector.finish(false, push_time + release_time);
+      record_weld();
+      set_loop_completed();
+    } else if (weld_parameters.is_early_release && !valve_scheduler.is_pending(zyl_schweisstaste) &&
+               weld_detector.is_completed(werkzeug_bereit.get_state())) {
+      weld_detector.finish(true, push_time + release_time);
+      record_weld();
       set_loop_completed();
     }
   };
+
+  void record_weld() {
+    thermal_model.add_weld(weld_detector.get_last_weld_time());
+    eeprom_counter.set_value(tool_temperature, thermal_model.get_temperature());
+  }
 };
 // -----------------------------------------------------------------------------
 // Abkühlen und Druck abbauen
-class Abkuehlen : public Cycle_step {
-  String get_display_text() { return "ENTLUEFTEN"; }
+class Abkuehlen {
+public:
+  const __FlashStringHelper *get_display_text() { return F("ENTLUEFTEN"); }
 
   void do_initial_stuff() {
     delay_cycle_step.set_unstarted();
     zyl_block_klemmrad.set(1);
     pneumatic_spring_vent();
+    start_vent_detector();
   };
   void do_loop_stuff() {
-    if (pressure_float < 0.1) // warten bis der Druck abgebaut ist
+    if (vent_detector.is_vented()) {
+      vent_detector.finish(true);
+      set_loop_completed();
+    } else if (pressure_mbar < 100) // warten bis der Druck abgebaut ist
     {
       if (delay_cycle_step.delay_time_is_up(500)) { // Restluft kann entweichen
+        vent_detector.finish(false);
         set_loop_completed();
       }
     }
   };
 };
 // -----------------------------------------------------------------------------
-class Wippenhebel : public Cycle_step {
-  String get_display_text() { return "WIPPENHEBEL"; }
+class Wippenhebel {
+public:
+  const __FlashStringHelper *get_display_text() { return F("WIPPENHEBEL"); }
 
-  void do_initial_stuff() { zyl_block_klemmrad.set(1); };
+  void do_initial_stuff() {
+    zyl_block_klemmrad.set(1);
+    start_stroke(stroke_wippenhebel, 1300, 50);
+  };
   void do_loop_stuff() {
-    zyl_wippenhebel.stroke(1300, 50);
-
-    if (zyl_wippenhebel.stroke_completed()) {
+    if (stroke_wippenhebel.is_completed()) {
       set_loop_completed();
     }
   };
 };
 // -----------------------------------------------------------------------------
-class Entspannen : public Cycle_step {
-  String get_display_text() { return "ENTSPANNEN"; }
+class Entspannen {
+public:
+  const __FlashStringHelper *get_display_text() { return F("ENTSPANNEN"); }
 
   void do_initial_stuff() {
     delay_cycle_step.set_unstarted();
@@ -1269,13 +1457,20 @@ class Entspannen : public Cycle_step {
 };
 // -----------------------------------------------------------------------------
 
-class Zurueckfahren : public Cycle_step {
-  String get_display_text() { return "ZURUECKFAHREN"; }
+class Zurueckfahren {
+public:
+  const __FlashStringHelper *get_display_text() { return F("ZURUECKFAHREN"); }
+
+  Edge_event first_contact;
+  bool startposition_is_reached;
+  bool is_venting;
 
   void do_initial_stuff() {
     zyl_startklemme.set(0);
     pneumatic_spring_move();
     delay_cycle_step.set_unstarted();
+    start_watching_switch(taster_startposition, first_contact, startposition_is_reached);
+    is_venting = false;
   };
   void do_loop_stuff() {
     if (is_in_display_debug_mode) {
@@ -1283,40 +1478,65 @@ class Zurueckfahren : public Cycle_step {
       eeprom_counter.count_one_up(longtime_counter);
       set_loop_completed();
     };
-    if (taster_startposition.get_raw_button_state()) {
+    read_switch_edges(taster_startposition, first_contact, startposition_is_reached);
+    if (startposition_is_reached && taster_startposition.get_state()) {
       pneumatic_spring_vent();
-      if (pressure_float < 0.1) // warten bis der Druck abgebaut ist
+      if (!is_venting) {
+        start_vent_detector();
+        is_venting = true;
+      }
+      if (vent_detector.is_vented()) {
+        vent_detector.finish(true);
+        complete_cycle();
+      } else if (pressure_mbar < 100) // warten bis der Druck abgebaut ist
       {
         if (delay_cycle_step.delay_time_is_up(50)) {
-          eeprom_counter.count_one_up(shorttime_counter);
-          eeprom_counter.count_one_up(longtime_counter);
-          set_loop_completed();
+          vent_detector.finish(false);
+          complete_cycle();
         }
       }
     }
   };
+  void complete_cycle() {
+    eeprom_counter.count_one_up(shorttime_counter);
+    eeprom_counter.count_one_up(longtime_counter);
+    set_loop_completed();
+  }
 };
 // -----------------------------------------------------------------------------
-class Cooldown : public Cycle_step {
-  String get_display_text() { return "ABKUEHLEN"; }
+class Cooldown {
+public:
+  const __FlashStringHelper *get_display_text() { return F("ABKUEHLEN"); }
   byte testZyklenZaehler;
   long abkuehldauer;
 
   void do_initial_stuff() {
     timeout_count = 0;
-    error_message = "";
+    error_message = no_error;
     testZyklenZaehler++;
-    abkuehldauer = eeprom_counter.get_value(long_cooldown_time) * 1000;
+    if (thermal_parameters.is_adaptive) {
+      abkuehldauer = thermal_model.get_required_pause() * 1000L; // keeps the tool below its limit
+    } else {
+      abkuehldauer = eeprom_counter.get_value(long_cooldown_time) * 1000;
+    }
     timeout_long_pause.set_time(abkuehldauer);
   };
 
+  bool is_pausing() {
+    if (thermal_parameters.is_adaptive) {
+      return abkuehldauer > 0;
+    }
+    return testZyklenZaehler >= eeprom_counter.get_value(cycles_in_a_row);
+  }
+
   void do_loop_stuff() {
-    if (testZyklenZaehler >= eeprom_counter.get_value(cycles_in_a_row)) {
+    if (is_pausing()) {
       timeout_machine_stopped.reset_time(); // Deactivate timeout error during pause.
       if (timeout_long_pause.has_timed_out()) {
         testZyklenZaehler = 0;
-        display_text_in_info_field("");
         set_loop_completed();
+      } else if (state_controller.is_in_auto_mode()) {
+        step_overlap.run(state_controller.get_current_step()); // prepare the next strap
       }
     } else {
       set_loop_completed();
@@ -1327,10 +1547,188 @@ class Cooldown : public Cycle_step {
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
+// CYCLE STEP OBJECTS AND TABLE ************************************************
+// TABLE SEQUENCE = CYCLE SEQUENCE !
+
+Aufwecken aufwecken;
+Vorschieben vorschieben;
+Schneiden schneiden;
+Stirzel stirzel;
+Festklemmen festklemmen;
+Startdruck startdruck;
+Spannen spannen;
+Pause pause_step;
+Schweissen schweissen;
+Abkuehlen abkuehlen;
+Wippenhebel wippenhebel;
+Entspannen entspannen;
+Zurueckfahren zurueckfahren;
+Cooldown cooldown;
+
+const Cycle_step main_cycle_steps[] PROGMEM = {
+    make_cycle_step<Aufwecken, aufwecken>(),
+    make_cycle_step<Vorschieben, vorschieben>(),
+    make_cycle_step<Schneiden, schneiden>(),
+    make_cycle_step<Stirzel, stirzel>(),
+    make_cycle_step<Festklemmen, festklemmen>(),
+    make_cycle_step<Startdruck, startdruck>(),
+    make_cycle_step<Spannen, spannen>(),
+    make_cycle_step<Pause, pause_step>(),
+    make_cycle_step<Schweissen, schweissen>(),
+    make_cycle_step<Abkuehlen, abkuehlen>(),
+    make_cycle_step<Wippenhebel, wippenhebel>(),
+    make_cycle_step<Entspannen, entspannen>(),
+    make_cycle_step<Zurueckfahren, zurueckfahren>(),
+    make_cycle_step<Cooldown, cooldown>(),
+};
+
+// STEP RESOURCES **************************************************************
+// Cylinders and timers a step owns, order must match the step table.
+// The first steps prepare the next strap, they can run during the cooldown.
+enum step_resource {
+  res_wippenhebel = 1 << 0,
+  res_klemmrad = 1 << 1,
+  res_foerdermotor = 1 << 2,
+  res_messer = 1 << 3,
+  res_startklemme = 1 << 4,
+  res_spanntaste = 1 << 5,
+  res_schweisstaste = 1 << 6,
+  res_pneumatic_spring = 1 << 7,
+  res_delay_cycle_step = 1 << 8,
+  res_long_pause = 1 << 9
+};
+
+const Step_resources TOOL = res_startklemme | res_spanntaste | res_schweisstaste | res_pneumatic_spring;
+
+const Step_resources main_cycle_step_resources[] PROGMEM = {
+    res_wippenhebel | res_delay_cycle_step, // Aufwecken
+    res_wippenhebel | res_klemmrad | res_foerdermotor | res_delay_cycle_step, // Vorschieben
+    res_messer, // Schneiden
+    res_klemmrad | res_foerdermotor | res_delay_cycle_step, // Stirzel
+    res_startklemme | res_wippenhebel | res_delay_cycle_step, // Festklemmen
+    res_klemmrad | res_pneumatic_spring | res_delay_cycle_step, // Startdruck
+    res_spanntaste | res_klemmrad | res_pneumatic_spring, // Spannen
+    res_delay_cycle_step, // Pause
+    res_spanntaste | res_schweisstaste | res_pneumatic_spring, // Schweissen
+    res_klemmrad | res_pneumatic_spring | res_delay_cycle_step, // Abkuehlen
+    res_klemmrad | res_wippenhebel, // Wippenhebel
+    res_startklemme | res_delay_cycle_step, // Entspannen
+    res_startklemme | res_pneumatic_spring | res_delay_cycle_step, // Zurueckfahren
+    TOOL | res_long_pause, // Cooldown
+};
+
+const byte NUMBER_OF_PREPARATION_STEPS = 4; // Aufwecken, Vorschieben, Schneiden, Stirzel
+
+static_assert(sizeof(main_cycle_step_resources) / sizeof(Step_resources) ==
+                  sizeof(main_cycle_steps) / sizeof(Cycle_step),
+              "one resource declaration per step");
+
+// STEP TIMEOUTS ***************************************************************
+// Expected duration and timeout of every step [ms], order must match the step
+// table. The timeout can be overridden by the eeprom (first_step_timeout...).
+const Step_timeout main_cycle_step_timeouts[] PROGMEM = {
+    {1300, 3000}, // Aufwecken
+    {500, 4000}, // Vorschieben, feed time up to 2000
+    {1800, 3000}, // Schneiden
+    {200, 1000}, // Stirzel
+    {400, 1000}, // Festklemmen
+    {1500, 8000}, // Startdruck
+    {1400, 4000}, // Spannen, endposition not reached
+    {800, 1500}, // Pause
+    {4000, 9000}, // Schweissen, stroke 7800
+    {500, 5000}, // Abkuehlen
+    {1350, 2500}, // Wippenhebel
+    {1000, 2000}, // Entspannen
+    {2000, 5000}, // Zurueckfahren, startposition not reached
+    {0, 0}, // Cooldown, not watched: the pause has its own timer
+};
+
+static_assert(sizeof(main_cycle_step_timeouts) / sizeof(Step_timeout) ==
+                  sizeof(main_cycle_steps) / sizeof(Cycle_step),
+              "one timeout per step");
+static_assert(last_step_timeout - first_step_timeout + 1 == sizeof(main_cycle_steps) / sizeof(Cycle_step),
+              "one eeprom timeout per step");
+
+// STEP DEPENDENCIES ***********************************************************
+// Steps that must be completed before a step starts (earlier steps only),
+// order must match the step table. Used by the step graph in auto mode.
+enum step_bit {
+  aufwecken_done = 1 << 0,
+  vorschieben_done = 1 << 1,
+  schneiden_done = 1 << 2,
+  stirzel_done = 1 << 3,
+  festklemmen_done = 1 << 4,
+  startdruck_done = 1 << 5,
+  spannen_done = 1 << 6,
+  pause_done = 1 << 7,
+  schweissen_done = 1 << 8,
+  abkuehlen_done = 1 << 9,
+  wippenhebel_done = 1 << 10,
+  entspannen_done = 1 << 11,
+  zurueckfahren_done = 1 << 12
+};
+
+const Step_set main_cycle_step_prerequisites[] PROGMEM = {
+    0, // Aufwecken
+    aufwecken_done, // Vorschieben
+    vorschieben_done, // Schneiden
+    schneiden_done, // Stirzel
+    stirzel_done, // Festklemmen
+    festklemmen_done, // Startdruck
+    startdruck_done, // Spannen
+    spannen_done, // Pause
+    pause_done, // Schweissen
+    schweissen_done, // Abkuehlen
+    abkuehlen_done, // Wippenhebel
+    abkuehlen_done, // Entspannen, independent of the wippenhebel
+    wippenhebel_done | entspannen_done, // Zurueckfahren
+    zurueckfahren_done, // Cooldown
+};
+
+static_assert(sizeof(main_cycle_step_prerequisites) / sizeof(Step_set) ==
+                  sizeof(main_cycle_steps) / sizeof(Cycle_step),
+              "one prerequisite declaration per step");
+
+// MAIN LOOP TASKS *************************************************************
+// {function, period [ms], priority (0 = highest), budget [us]}
+// Order must match enum loop_task.
+const Scheduled_task task_table[end_of_task_enum] PROGMEM = {
+    {run_safety_task, 1, 0, 200},
+    {run_pressure_task, 1, 1, 300},
+    {run_step_task, 1, 2, 500},
+    {run_display_task, 10, 3, 2000},
+    {run_telemetry_task, 20, 4, 5000},
+};
+
 // SETUP LOOP ------------------------------------------------------------------
 
+// The values added with layout 2 start with 0: tool at ambient temperature,
+// timeouts of the step table:
+void migrate_eeprom_layout() {
+  if (eeprom_counter.get_value(eeprom_layout) == EEPROM_LAYOUT_VERSION) {
+    return;
+  }
+  EEPROM_Counter eeprom_layout_1;
+  eeprom_layout_1.setup(eeprom_min_address, eeprom_max_address, NUMBER_OF_EEPROM_VALUES_LAYOUT_1);
+  long values[NUMBER_OF_EEPROM_VALUES_LAYOUT_1];
+  for (int i = 0; i < NUMBER_OF_EEPROM_VALUES_LAYOUT_1; i++) {
+    values[i] = eeprom_layout_1.get_value(i); // read all before the first write
+  }
+  for (int i = 0; i < NUMBER_OF_EEPROM_VALUES_LAYOUT_1; i++) {
+    eeprom_counter.set_value(i, values[i]);
+  }
+  for (int i = NUMBER_OF_EEPROM_VALUES_LAYOUT_1; i < eeprom_layout; i++) {
+    eeprom_counter.set_value(i, 0);
+  }
+  eeprom_counter.set_value(eeprom_layout, EEPROM_LAYOUT_VERSION);
+}
+
 void setup() {
   eeprom_counter.setup(eeprom_min_address, eeprom_max_address, number_of_eeprom_values);
+  migrate_eeprom_layout();
+  thermal_model.set_temperature(eeprom_counter.get_value(tool_temperature));
+
+  nextion_widgets.setup(nextion_widget_table, nextion_widget_states, end_of_widget_enum);
 
   // eeprom_counter.set_value(longtime_counter, 2510);
 
@@ -1339,29 +1737,27 @@ void setup() {
   nextion_setup();
 
   pinMode(DRUCKSENSOR, INPUT);
+  pressure_sampler.begin();
+  Edge_capture::begin();
+  valve_scheduler.begin();
 
   delay(2000);
 
-  //------------------------------------------------
-  // PUSH THE CYCLE STEPS INTO THE VECTOR CONTAINER:
-  // PUSH SEQUENCE = CYCLE SEQUENCE !
-  main_cycle_steps.push_back(new Aufwecken);
-  main_cycle_steps.push_back(new Vorschieben); //--------------------------
-  main_cycle_steps.push_back(new Schneiden);
-  main_cycle_steps.push_back(new Stirzel); ///------------------------
-  main_cycle_steps.push_back(new Festklemmen);
-  main_cycle_steps.push_back(new Startdruck);
-  main_cycle_steps.push_back(new Spannen);
-  main_cycle_steps.push_back(new Pause);
-  main_cycle_steps.push_back(new Schweissen);
-  main_cycle_steps.push_back(new Abkuehlen);
-  main_cycle_steps.push_back(new Wippenhebel);
-  main_cycle_steps.push_back(new Entspannen);
-  main_cycle_steps.push_back(new Zurueckfahren);
-  main_cycle_steps.push_back(new Cooldown);
+  cycle_steps.setup(main_cycle_steps, sizeof(main_cycle_steps) / sizeof(Cycle_step));
+  step_overlap.setup(main_cycle_step_resources, 0, NUMBER_OF_PREPARATION_STEPS);
+  step_graph.setup(main_cycle_step_resources, main_cycle_step_prerequisites);
+  step_watchdog.setup(main_cycle_step_timeouts);
+  for (byte i = 0; i < cycle_steps.get_number_of_steps(); i++) {
+    long limit = eeprom_counter.get_value(first_step_timeout + i);
+    if (limit < 0 || limit > 60000) { // not set, erased eeprom
+      limit = 0;
+    }
+    step_watchdog.set_limit(i, limit);
+  }
+
   //------------------------------------------------
   // CONFIGURE THE STATE CONTROLLER:
-  state_controller.set_no_of_steps(main_cycle_steps.size());
+  state_controller.set_no_of_steps(cycle_steps.get_number_of_steps());
   //------------------------------------------------
 
   state_controller.set_step_mode();
@@ -1372,23 +1768,40 @@ void setup() {
 
   reset_flag_of_current_step();
 
+  task_scheduler.setup(task_table, task_states, end_of_task_enum);
+
+  memory_monitor.paint_free_ram();
+  print_memory_report();
+
   Serial.println("EXIT SETUP");
 }
 
 // MAIN LOOPS ******************************************************************
 
+// Steps prepared during the cooldown are skipped, a started one continues:
+void switch_to_next_cycle_step() {
+  state_controller.switch_to_next_step();
+  if (step_overlap.is_active() && state_controller.get_current_step() == step_overlap.get_first_step()) {
+    state_controller.set_current_step_to(step_overlap.finish());
+  } else {
+    reset_flag_of_current_step();
+  }
+}
+
 // STEP MODE -------------------------------------------------------------------
 void run_step_mode() {
+  if (step_graph.is_active()) {
+    state_controller.set_current_step_to(step_graph.stop()); // continue in serial order
+  }
 
   // IF MACHINE STATE IS "RUNNING", RUN CURRENT STEP:
   if (state_controller.machine_is_running()) {
-    main_cycle_steps[state_controller.get_current_step()]->do_stuff();
+    cycle_steps.do_stuff(state_controller.get_current_step());
   }
 
   // IF STEP IS COMPLETED SWITCH TO NEXT STEP:
-  if (main_cycle_steps[state_controller.get_current_step()]->is_completed()) {
-    state_controller.switch_to_next_step();
-    reset_flag_of_current_step();
+  if (cycle_steps.is_completed(state_controller.get_current_step())) {
+    switch_to_next_cycle_step();
   }
 
   // RIG STOPS AFTER EVERY COMPLETED STEP:
@@ -1398,16 +1811,44 @@ void run_step_mode() {
 }
 
 // AUTO MODE -------------------------------------------------------------------
+// Steps before the current one and steps prepared during the cooldown are
+// completed, a started step continues:
+void start_step_graph_cycle() {
+  Step_set completed_steps = bit(state_controller.get_current_step()) - 1;
+  if (step_overlap.is_active()) {
+    completed_steps = bit(step_overlap.finish()) - 1;
+  }
+  step_graph.start_cycle(completed_steps);
+}
+
+void run_step_graph() {
+  if (!step_graph.is_active() || step_graph.is_cycle_completed()) {
+    start_step_graph_cycle();
+  }
+  if (state_controller.machine_is_running()) {
+    step_graph.run();
+  }
+  state_controller.set_current_step_to(step_graph.get_current_step()); // shown on the display
+
+  // RESET "MACHINE STOPPED ERROR TIMEOUT" AFTER EVERY STEP:
+  if (state_controller.step_switch_has_happend()) {
+    timeout_machine_stopped.reset_time();
+  }
+}
+
 void run_auto_mode() {
+  if (runs_steps_in_parallel) {
+    run_step_graph();
+    return;
+  }
   // IF MACHINE STATE IS "RUNNING", RUN CURRENT STEP:
   if (state_controller.machine_is_running()) {
-    main_cycle_steps[state_controller.get_current_step()]->do_stuff();
+    cycle_steps.do_stuff(state_controller.get_current_step());
   }
 
   // IF STEP IS COMPLETED SWITCH TO NEXT STEP:
-  if (main_cycle_steps[state_controller.get_current_step()]->is_completed()) {
-    state_controller.switch_to_next_step();
-    reset_flag_of_current_step();
+  if (cycle_steps.is_completed(state_controller.get_current_step())) {
+    switch_to_next_cycle_step();
   }
 
   // RESET "MACHINE STOPPED ERROR TIMEOUT" AFTER EVERY STEP:
@@ -1422,10 +1863,13 @@ void monitor_strap_detectors() {
   if (is_in_display_debug_mode) {
     return;
   }
-  if (!bandsensor_oben.get_raw_button_state() || !bandsensor_unten.get_raw_button_state()) {
+  if (!bandsensor_oben.get_state() || !bandsensor_unten.get_state()) {
+    valve_scheduler.cancel_all(); // no pending stroke must switch after the stop
     state_controller.set_machine_stop();
     state_controller.set_error_mode();
-    error_message = "KEIN BAND";
+    step_graph.cancel(); // parallel and prepared steps start again with their initial stuff
+    step_overlap.cancel();
+    error_message = error_kein_band;
     zyl_wippenhebel.set(0);
     zyl_spanntaste.set(0);
     zyl_schweisstaste.set(0);
@@ -1439,7 +1883,7 @@ void monitor_strap_detectors() {
 
 void manage_timeout_actions() {
   stop_machine();
-  error_message = "STOPPED";
+  error_message = error_stopped;
   state_controller.set_error_mode();
 
   // // TIMEOUT 1
@@ -1461,7 +1905,37 @@ void manage_timeout_actions() {
   // }
 }
 
+void print_step_timeout() {
+  byte step = step_watchdog.get_fault_step();
+  Serial.print(F("STEP TIMEOUT: "));
+  Serial.print(step);
+  Serial.print(F(" "));
+  Serial.print(cycle_steps.get_display_text(step));
+  Serial.print(F(" "));
+  Serial.print(step_watchdog.get_fault_duration());
+  Serial.print(F(" ms (EXPECTED "));
+  Serial.print(step_watchdog.get_expected_duration(step));
+  Serial.print(F(" LIMIT "));
+  Serial.print(step_watchdog.get_limit(step));
+  Serial.println(F(")"));
+}
+
+void manage_step_timeout_actions() {
+  stop_machine();
+  error_message = error_step_timeout;
+  state_controller.set_error_mode();
+  print_step_timeout();
+}
+
 void monitor_timeout() {
+  // Every step has its own timeout, only counted while the machine is running:
+  step_watchdog.update(state_controller.machine_is_running());
+  if (step_watchdog.has_fired()) {
+    timeout_count++;
+    manage_step_timeout_actions();
+    return;
+  }
+
   // Reset timeout if machine is not running:
   if (!state_controller.machine_is_running()) {
     timeout_machine_stopped.reset_time();
@@ -1473,24 +1947,388 @@ void monitor_timeout() {
   }
 }
 
+// USB SERIAL COMMANDS ---------------------------------------------------------
+void print_memory_report() {
+  Serial.print(F("RAM STATIC: "));
+  Serial.print(memory_monitor.get_static_ram());
+  Serial.print(F(" HEAP: "));
+  Serial.print(memory_monitor.get_heap_size());
+  Serial.print(F(" FREE: "));
+  Serial.print(memory_monitor.get_free_ram());
+  Serial.print(F(" MIN FREE: "));
+  Serial.println(memory_monitor.get_min_free_ram());
+}
+
+void print_step_profile() {
+  Step_profiler &profiler = cycle_steps.get_profiler();
+  Serial.println(F("STEP PROFILE [ms]: NO. STEP COUNT MIN MEAN MAX LAST"));
+  for (byte i = 0; i < cycle_steps.get_number_of_steps(); i++) {
+    Serial.print(i);
+    Serial.print(F(" "));
+    Serial.print(cycle_steps.get_display_text(i));
+    Serial.print(F(" "));
+    Serial.print(profiler.get_completion_count(i));
+    Serial.print(F(" "));
+    Serial.print(profiler.get_min_duration(i));
+    Serial.print(F(" "));
+    Serial.print(profiler.get_mean_duration(i));
+    Serial.print(F(" "));
+    Serial.print(profiler.get_max_duration(i));
+    Serial.print(F(" "));
+    Serial.println(profiler.get_last_duration(i));
+  }
+}
+
+const __FlashStringHelper *get_task_name(byte task) {
+  switch (task) {
+  case task_safety:
+    return F("SAFETY");
+  case task_pressure:
+    return F("PRESSURE");
+  case task_steps:
+    return F("STEPS");
+  case task_display:
+    return F("DISPLAY");
+  case task_telemetry:
+    return F("TELEMETRY");
+  }
+  return F("?");
+}
+
+// Prints one line per histogram, the counts of bucket 0 (0..1us) first:
+void print_histogram_line(int section) {
+  for (byte bucket = 0; bucket < SCAN_MONITOR_BUCKETS; bucket++) {
+    Serial.print(F(" "));
+    if (section < 0) {
+      Serial.print(scan_monitor.get_scan_count(bucket));
+    } else {
+      Serial.print(scan_monitor.get_section_count(section, bucket));
+    }
+  }
+  Serial.println();
+}
+
+void print_and_reset_scan_report() {
+  Serial.println(F("SCAN TIME HISTOGRAM, BUCKET N = 2^N..2^(N+1)-1 [us]:"));
+  Serial.print(F("LOOP"));
+  print_histogram_line(-1);
+  for (byte i = 0; i < end_of_task_enum; i++) {
+    Serial.print(get_task_name(i));
+    print_histogram_line(i);
+  }
+  Serial.print(F("WORST SCAN [us]: "));
+  Serial.print(scan_monitor.get_worst_scan_time());
+  Serial.print(F(" MOSTLY "));
+  Serial.println(get_task_name(scan_monitor.get_worst_scan_section()));
+  Serial.print(F("WORST SECTIONS [us]:"));
+  for (byte i = 0; i < end_of_task_enum; i++) {
+    Serial.print(F(" "));
+    Serial.print(get_task_name(i));
+    Serial.print(F("="));
+    Serial.print(scan_monitor.get_worst_section_time(i));
+  }
+  Serial.println();
+  scan_monitor.reset();
+}
+
+void print_and_reset_task_report() {
+  Serial.println(F("TASKS: NAME LATE OVERRUN WORST [us]"));
+  for (byte i = 0; i < end_of_task_enum; i++) {
+    Serial.print(get_task_name(i));
+    Serial.print(F(" "));
+    Serial.print(task_scheduler.get_late_count(i));
+    Serial.print(F(" "));
+    Serial.print(task_scheduler.get_overrun_count(i));
+    Serial.print(F(" "));
+    Serial.println(task_scheduler.get_worst_run_time(i));
+  }
+  task_scheduler.reset_statistics();
+}
+
+void print_switch_latency(const __FlashStringHelper *name, Edge_capture &position_switch) {
+  Serial.print(name);
+  Serial.print(F(" "));
+  Serial.print(position_switch.get_last_latency());
+  Serial.print(F(" "));
+  Serial.print(position_switch.get_mean_latency());
+  Serial.print(F(" "));
+  Serial.print(position_switch.get_max_latency());
+  Serial.print(F(" "));
+  Serial.println(position_switch.get_overrun_count());
+}
+
+void print_switch_latencies() {
+  Serial.println(F("SWITCH TO VALVE [us]: SWITCH LAST MEAN MAX LOST EDGES"));
+  print_switch_latency(F("ENDPOSITION"), taster_endposition);
+  print_switch_latency(F("STARTPOSITION"), taster_startposition);
+  Serial.print(F("VALVE EVENTS MAX LATE [us]: "));
+  Serial.println(valve_scheduler.get_max_lateness());
+}
+
+const __FlashStringHelper *get_mode_name(byte mode) {
+  switch (mode) {
+  case step_mode:
+    return F("STEP");
+  case auto_mode:
+    return F("AUTO");
+  case error_mode:
+    return F("ERROR");
+  case reset_mode:
+    return F("RESET");
+  }
+  return F("?");
+}
+
+void print_mode_log() {
+  Serial.println(F("MODE CHANGES, LATEST FIRST: TIME [ms] EVENT MODE"));
+  for (byte i = 0; i < state_controller.get_number_of_logged_transitions(); i++) {
+    Mode_transition transition = state_controller.get_logged_transition(i);
+    Serial.print(transition.time);
+    Serial.print(F(" "));
+    Serial.print(transition.event);
+    Serial.print(F(" "));
+    Serial.print(get_mode_name(transition.previous_mode));
+    Serial.print(F(" -> "));
+    Serial.println(get_mode_name(transition.mode));
+  }
+}
+
+void print_fill_controller() {
+  Serial.print(F("FILL GAIN [N/ms Q8]: FIRST "));
+  Serial.print(fill_controller.get_gain(first_pulse_gain));
+  Serial.print(F(" TOP UP "));
+  Serial.print(fill_controller.get_gain(top_up_gain));
+  Serial.print(F(" PULSES "));
+  Serial.print(fill_controller.get_pulse_count());
+  Serial.print(F(" FALLBACKS "));
+  Serial.println(fill_controller.get_fallback_count());
+}
+
+const __FlashStringHelper *get_vent_decision_name(byte kind) {
+  switch (kind) {
+  case vent_predicted:
+    return F("PREDICTED");
+  case vent_measured:
+    return F("MEASURED");
+  case vent_threshold:
+    return F("THRESHOLD");
+  }
+  return F("?");
+}
+
+void print_vent_log() {
+  Serial.println(F("VENT LOG (LATEST FIRST): STEP END [ms] PREDICTED [ms] RATIO [Q16] WINDOWS"));
+  for (byte i = 0; i < vent_detector.get_number_of_logged_decisions(); i++) {
+    Vent_decision decision = vent_detector.get_logged_decision(i);
+    Serial.print(decision.step);
+    Serial.print(F(" "));
+    Serial.print(get_vent_decision_name(decision.kind));
+    Serial.print(F(" "));
+    Serial.print(decision.vent_time);
+    Serial.print(F(" "));
+    Serial.print(decision.predicted_time);
+    Serial.print(F(" "));
+    Serial.print(decision.decay_ratio);
+    Serial.print(F(" "));
+    Serial.println(decision.fitted_windows);
+  }
+}
+
+void print_weld_statistics() {
+  Serial.print(F("WELDS "));
+  Serial.print(weld_detector.get_weld_count());
+  Serial.print(F(" RELEASED EARLY "));
+  Serial.print(weld_detector.get_early_release_count());
+  Serial.print(F(" LAST [ms] "));
+  Serial.print(weld_detector.get_last_weld_time());
+  Serial.print(F(" SAVED [ms]: LAST "));
+  Serial.print(weld_detector.get_last_time_saved());
+  Serial.print(F(" MEAN "));
+  Serial.print(weld_detector.get_mean_time_saved());
+  Serial.print(F(" TOTAL [s] "));
+  Serial.println(weld_detector.get_total_time_saved());
+}
+
+void print_step_graph_report() {
+  Serial.print(F("CYCLE TIME [ms]: SERIAL "));
+  Serial.print(step_graph.get_serial_time());
+  Serial.print(F(" CRITICAL PATH "));
+  Serial.print(step_graph.get_critical_path_time());
+  Serial.print(F(" LAST GRAPH CYCLE "));
+  Serial.println(step_graph.get_last_cycle_time());
+  Serial.print(F("CRITICAL PATH:"));
+  Step_set critical_path = step_graph.get_critical_path();
+  for (byte i = 0; i < cycle_steps.get_number_of_steps(); i++) {
+    if (critical_path & bit(i)) {
+      Serial.print(F(" "));
+      Serial.print(i);
+    }
+  }
+  Serial.println();
+}
+
+void print_thermal_model() {
+  Serial.print(thermal_parameters.is_adaptive ? F("ADAPTIVE") : F("FIXED"));
+  Serial.print(F(" COOLDOWN, TOOL [0.1K] "));
+  Serial.print(thermal_model.get_temperature());
+  Serial.print(F(" LIMIT "));
+  Serial.print(thermal_parameters.temperature_limit);
+  Serial.print(F(" LAST PAUSE [s] "));
+  Serial.println(thermal_model.get_last_pause());
+}
+
+void print_step_timeouts() {
+  Serial.print(F("STEP TIMEOUTS [ms]: NO. STEP EXPECTED LIMIT / FAULTS "));
+  Serial.println(step_watchdog.get_fault_count());
+  for (byte i = 0; i < cycle_steps.get_number_of_steps(); i++) {
+    Serial.print(i);
+    Serial.print(F(" "));
+    Serial.print(cycle_steps.get_display_text(i));
+    Serial.print(F(" "));
+    Serial.print(step_watchdog.get_expected_duration(i));
+    Serial.print(F(" "));
+    Serial.println(step_watchdog.get_limit(i));
+  }
+  if (step_watchdog.get_fault_count()) {
+    print_step_timeout();
+  }
+}
+
+// "D<step> <limit [ms]>" and newline sets the timeout of a step and stores it
+// in the eeprom, limit 0 = timeout of the step table:
+bool is_reading_step_timeout = false;
+long step_timeout_input[2]; // step, limit [ms]
+byte step_timeout_input_index;
+
+void set_step_timeout(long step, long limit) {
+  if (step >= cycle_steps.get_number_of_steps() || limit > 60000) {
+    Serial.println(F("STEP TIMEOUT NOT SET, STEP OR LIMIT OUT OF RANGE"));
+    return;
+  }
+  eeprom_counter.set_value(first_step_timeout + step, limit);
+  step_watchdog.set_limit(step, limit);
+  print_step_timeouts();
+}
+
+void read_step_timeout_input(char character) {
+  if (character >= '0' && character <= '9') {
+    long &value = step_timeout_input[step_timeout_input_index];
+    if (value <= 60000) { // larger is out of range anyway
+      value = value * 10 + character - '0';
+    }
+    return;
+  }
+  if (character == ' ' && step_timeout_input_index == 0) {
+    step_timeout_input_index = 1;
+    return;
+  }
+  if (character == '\r') {
+    return;
+  }
+  is_reading_step_timeout = false;
+  if (character == '\n' && step_timeout_input_index == 1) {
+    set_step_timeout(step_timeout_input[0], step_timeout_input[1]);
+  } else {
+    Serial.println(F("USAGE: D<STEP> <LIMIT [ms]>"));
+  }
+}
+
+void monitor_serial_commands() {
+  if (!Serial.available()) {
+    return;
+  }
+  char command = Serial.read();
+  if (is_reading_step_timeout) {
+    read_step_timeout_input(command);
+    return;
+  }
+  switch (command) {
+  case 'm': // memory
+    print_memory_report();
+    break;
+  case 'p': // step profile
+    print_step_profile();
+    break;
+  case 'P': // reset step profile
+    cycle_steps.get_profiler().reset();
+    Serial.println(F("STEP PROFILE RESET"));
+    break;
+  case 's': // scan time, reset after printing
+    print_and_reset_scan_report();
+    break;
+  case 't': // tasks, reset after printing
+    print_and_reset_task_report();
+    break;
+  case 'l': // latency of the position switches
+    print_switch_latencies();
+    break;
+  case 'o': // operation mode changes
+    print_mode_log();
+    break;
+  case 'f': // fill controller of the startdruck
+    print_fill_controller();
+    break;
+  case 'v': // vent decisions of abkuehlen and zurueckfahren
+    print_vent_log();
+    break;
+  case 'w': // weld statistics
+    print_weld_statistics();
+    break;
+  case 'g': // step graph, critical path and serial cycle time
+    print_step_graph_report();
+    break;
+  case 'd': // duration limits of the steps, last step timeout
+    print_step_timeouts();
+    break;
+  case 'D': // set the duration limit of a step, see read_step_timeout_input()
+    step_timeout_input[0] = 0;
+    step_timeout_input[1] = 0;
+    step_timeout_input_index = 0;
+    is_reading_step_timeout = true;
+    break;
+  case 'h': // heat of the welding tool
+    print_thermal_model();
+    break;
+  case 'W': // reset weld statistics
+    weld_detector.reset_statistics();
+    Serial.println(F("WELD STATISTICS RESET"));
+    break;
+  }
+}
+
 // RESET MODE ------------------------------------------------------------------
 void run_reset_mode() {
   if (state_controller.run_after_reset_is_active()) {
-    error_message = "RUN RESET " + String(timeout_count);
+    error_message = error_run_reset;
     state_controller.set_auto_mode();
     state_controller.set_machine_running();
   }
 }
 
-// MAIN LOOP -------------------------------------------------------------------
-void loop() {
+// MODE JUMP TABLE -------------------------------------------------------------
+void run_step_mode_task() {
+  state_controller.set_run_after_reset(false);
+  run_step_mode();
+}
 
-  // UPDATE DISPLAY:
-  nextion_loop();
+void run_auto_mode_task() {
+  state_controller.set_run_after_reset(true);
+  run_auto_mode();
+}
 
-  // MONITOR PRESSURE:
-  read_and_process_pressure();
+void run_error_mode_task() {}
+
+// Order must match enum machine_mode:
+typedef void (*Mode_function)();
+const Mode_function mode_functions[end_of_mode_enum] PROGMEM = {
+    run_step_mode_task,
+    run_auto_mode_task,
+    run_error_mode_task,
+    run_reset_mode,
+};
 
+// MAIN LOOP TASKS -------------------------------------------------------------
+void run_safety_task() {
   // CHECK IF STRAP IS AVAILABLE:
   monitor_strap_detectors();
 
@@ -1500,20 +2338,21 @@ void loop() {
   // CONTROL SIGNAL LIGHT:
   zyl_singal_red.set(state_controller.machine_is_running());
 
-  // RUN STEP MODE:
-  if (state_controller.is_in_step_mode()) {
-    state_controller.set_run_after_reset(false);
-    run_step_mode();
-  }
-  // RUN AUTO MODE:
-  else if (state_controller.is_in_auto_mode()) {
-    state_controller.set_run_after_reset(true);
-    run_auto_mode();
-  }
-  // RUN RESET MODE:
-  else if (state_controller.is_in_reset_mode()) {
-    run_reset_mode();
-  }
+  scan_monitor.end_section(task_safety);
+}
+
+void run_pressure_task() {
+  read_and_process_pressure();
+  scan_monitor.end_section(task_pressure);
+}
+
+void run_step_task() {
+  // EXECUTE WHAT HAS BEEN TOUCHED ON THE DISPLAY:
+  execute_touch_commands();
+
+  // RUN THE FUNCTION OF THE CURRENT MODE:
+  Mode_function run_mode = (Mode_function)pgm_read_ptr(&mode_functions[state_controller.get_mode()]);
+  run_mode();
 
   // RUN SPINNER:
   if (state_controller.machine_is_running()) {
@@ -1522,8 +2361,24 @@ void loop() {
     spinner_is_running = false;
   }
 
-  // // MEASURE CYCLE TIME
-  // runtime = micros() - runtime_stopwatch;
-  // Serial.println(runtime);
-  // runtime_stopwatch = micros();
+  scan_monitor.end_section(task_steps);
+}
+
+void run_display_task() {
+  nextion_loop();
+  scan_monitor.end_section(task_display);
+}
+
+void run_telemetry_task() {
+  // ANSWER USB SERIAL COMMANDS:
+  monitor_serial_commands();
+  scan_monitor.end_section(task_telemetry);
+}
+
+// MAIN LOOP -------------------------------------------------------------------
+void loop() {
+  scan_monitor.start_scan();
+  process_image.read_inputs();
+  task_scheduler.tick();
+  process_image.write_outputs(); // all valve changes of this scan at once
 }
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * memory_monitor.cpp **********************************************************
+ *******************************************************************************/
+
+#include "memory_monitor.h"
+
+#ifdef __AVR__
+
+extern char __heap_start; // provided by the linker
+extern char *__brkval; // end of the heap, 0 if malloc was never used
+
+const byte RAM_PAINT = 0xC5;
+const byte STACK_RESERVE = 64; // [bytes] keep clear below the stack pointer
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Memory_monitor::Memory_monitor() { _is_painted = false; }
+
+byte *Memory_monitor::get_heap_end() {
+  if (__brkval) {
+    return (byte *)__brkval;
+  }
+  return (byte *)&__heap_start;
+}
+
+// PAINT -----------------------------------------------------------------------
+void Memory_monitor::paint_free_ram() {
+  byte *ram = get_heap_end();
+  byte *stack_limit = (byte *)SP - STACK_RESERVE;
+  while (ram < stack_limit) {
+    *ram++ = RAM_PAINT;
+  }
+  _is_painted = true;
+}
+
+// GETTER ----------------------------------------------------------------------
+unsigned int Memory_monitor::get_static_ram() { return (size_t)&__heap_start - RAMSTART; }
+
+unsigned int Memory_monitor::get_heap_size() { return get_heap_end() - (byte *)&__heap_start; }
+
+unsigned int Memory_monitor::get_free_ram() { return (byte *)SP - get_heap_end(); }
+
+unsigned int Memory_monitor::get_min_free_ram() {
+  if (!_is_painted) {
+    return get_free_ram();
+  }
+  byte *ram = get_heap_end();
+  byte *stack_pointer = (byte *)SP;
+  unsigned int untouched_bytes = 0;
+  while (ram < stack_pointer && *ram == RAM_PAINT) {
+    untouched_bytes++;
+    ram++;
+  }
+  return untouched_bytes;
+}
+
+#else
+
+// The host build [env:native] has no fixed RAM layout to report:
+Memory_monitor::Memory_monitor() { _is_painted = false; }
+
+void Memory_monitor::paint_free_ram() {}
+
+unsigned int Memory_monitor::get_static_ram() { return 0; }
+
+unsigned int Memory_monitor::get_heap_size() { return 0; }
+
+unsigned int Memory_monitor::get_free_ram() { return 0; }
+
+unsigned int Memory_monitor::get_min_free_ram() { return 0; }
+
+#endif
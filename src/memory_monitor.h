@@ -0,0 +1,40 @@
+/* *****************************************************************************
+ * memory_monitor.h ************************************************************
+ * *****************************************************************************
+ * RAM USAGE AND HIGH WATER MARK (AVR)
+ *
+ * paint_free_ram() fills the unused RAM between heap and stack with a known
+ * pattern. Heap or stack growth overwrites the pattern, the untouched rest is
+ * the smallest amount of free RAM since painting.
+ * *****************************************************************************
+ */
+
+#ifndef MemoryMonitor_H_
+#define MemoryMonitor_H_
+
+#include <Arduino.h>
+
+class Memory_monitor {
+
+public:
+  // FUNCTIONS:
+  Memory_monitor();
+
+  void paint_free_ram();
+
+  unsigned int get_static_ram(); // .data and .bss
+  unsigned int get_heap_size();
+  unsigned int get_free_ram();
+  unsigned int get_min_free_ram();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  byte *get_heap_end();
+
+  // VARIABLES:
+  bool _is_painted;
+};
+#endif /* MemoryMonitor_H_ */
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * nextion_queue.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "nextion_queue.h"
+
+const byte NEXTION_TERMINATOR_LENGTH = 3; // 0xFF 0xFF 0xFF
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Nextion_queue::Nextion_queue(HardwareSerial &serial) : _serial(serial) {
+  _head = 0;
+  _tail = 0;
+  _pending_count = 0;
+  _transmit_position = 0;
+  _command_overflow = false;
+  reset_statistics();
+}
+
+// ASSEMBLE COMMAND ------------------------------------------------------------
+void Nextion_queue::begin_command() {
+  _lengths[_head] = 0;
+  _commands[_head][0] = '\0';
+  _command_overflow = false;
+}
+
+void Nextion_queue::append(char character) {
+  byte length = _lengths[_head];
+  if (length >= NEXTION_COMMAND_LENGTH) {
+    _command_overflow = true;
+    return;
+  }
+  _commands[_head][length] = character;
+  _commands[_head][length + 1] = '\0';
+  _lengths[_head] = length + 1;
+}
+
+void Nextion_queue::print(const char *text) {
+  while (*text) {
+    append(*text++);
+  }
+}
+
+void Nextion_queue::print(const __FlashStringHelper *text) {
+  PGM_P flash_text = reinterpret_cast<PGM_P>(text);
+  char character = pgm_read_byte(flash_text++);
+  while (character) {
+    append(character);
+    character = pgm_read_byte(flash_text++);
+  }
+}
+
+void Nextion_queue::print(long value) {
+  char digits[12];
+  ltoa(value, digits, 10);
+  print(digits);
+}
+
+// Prints a fixed point value, e.g. print_fixed(123, 1) => "12.3"
+void Nextion_queue::print_fixed(long value, byte decimals) {
+  if (value < 0) {
+    append('-');
+    value = -value;
+  }
+  long divisor = 1;
+  for (byte i = 0; i < decimals; i++) {
+    divisor *= 10;
+  }
+  print(value / divisor);
+  if (decimals == 0) {
+    return;
+  }
+  append('.');
+  long fraction = value % divisor;
+  char digits[11];
+  for (byte i = decimals; i > 0; i--) {
+    digits[i - 1] = '0' + fraction % 10;
+    fraction /= 10;
+  }
+  digits[decimals] = '\0';
+  print(digits);
+}
+
+// Returns false if the command was dropped (too long or queue full):
+bool Nextion_queue::end_command() {
+  // A truncated command would be misinterpreted by the display:
+  if (_command_overflow) {
+    _dropped_count++;
+    return false;
+  }
+  bool is_queued = true;
+  if (coalesce_with_pending()) {
+    _coalesced_count++;
+  } else if (_pending_count < NEXTION_QUEUE_DEPTH - 1) {
+    _head = next_slot(_head);
+    _pending_count++;
+    if (_pending_count > _high_water_mark) {
+      _high_water_mark = _pending_count;
+    }
+  } else {
+    _dropped_count++;
+    is_queued = false;
+  }
+  transmit();
+  return is_queued;
+}
+
+// Overwrite a pending assignment to the same attribute, e.g. "t2.txt=":
+bool Nextion_queue::coalesce_with_pending() {
+  const char *command = _commands[_head];
+  const char *assignment = strchr(command, '=');
+  if (!assignment) {
+    return false;
+  }
+  size_t key_length = assignment - command + 1;
+
+  byte slot = _tail;
+  for (byte i = 0; i < _pending_count; i++) {
+    // The command on the wire can not be changed anymore:
+    bool is_in_transmission = (slot == _tail && _transmit_position > 0);
+    if (!is_in_transmission && strncmp(_commands[slot], command, key_length) == 0) {
+      strcpy(_commands[slot], command);
+      _lengths[slot] = _lengths[_head];
+      return true;
+    }
+    slot = next_slot(slot);
+  }
+  return false;
+}
+
+byte Nextion_queue::next_slot(byte slot) {
+  slot++;
+  if (slot >= NEXTION_QUEUE_DEPTH) {
+    slot = 0;
+  }
+  return slot;
+}
+
+// TRANSMIT --------------------------------------------------------------------
+// Only write as many bytes as fit into the transmit buffer of the serial port,
+// writing more would block until the UART interrupt made room.
+void Nextion_queue::transmit() {
+  while (_pending_count > 0 && _serial.availableForWrite() > 0) {
+    byte length = _lengths[_tail];
+    if (_transmit_position < length) {
+      _serial.write(_commands[_tail][_transmit_position]);
+    } else {
+      _serial.write(0xFF);
+    }
+    _transmit_position++;
+
+    if (_transmit_position >= length + NEXTION_TERMINATOR_LENGTH) {
+      _transmit_position = 0;
+      _tail = next_slot(_tail);
+      _pending_count--;
+    }
+  }
+}
+
+// Commands for a page that is no longer shown must not reach the next page.
+// A command already on the wire will be completed.
+void Nextion_queue::discard_pending() {
+  if (_pending_count == 0) {
+    return;
+  }
+  if (_transmit_position > 0) {
+    _pending_count = 1;
+    _head = next_slot(_tail);
+  } else {
+    _pending_count = 0;
+    _head = _tail;
+  }
+}
+
+bool Nextion_queue::is_empty() { return _pending_count == 0; }
+
+// STATISTICS ------------------------------------------------------------------
+byte Nextion_queue::get_high_water_mark() { return _high_water_mark; }
+
+unsigned long Nextion_queue::get_dropped_count() { return _dropped_count; }
+
+unsigned long Nextion_queue::get_coalesced_count() { return _coalesced_count; }
+
+void Nextion_queue::reset_statistics() {
+  _high_water_mark = 0;
+  _dropped_count = 0;
+  _coalesced_count = 0;
+}
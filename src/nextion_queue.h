@@ -0,0 +1,80 @@
+/* *****************************************************************************
+ * nextion_queue.h *************************************************************
+ * *****************************************************************************
+ * NON BLOCKING TRANSMIT QUEUE FOR THE NEXTION DISPLAY
+ *
+ * Commands are assembled directly in a free slot of a ring buffer. The queue
+ * hands them over to the serial port only as far as the (interrupt driven)
+ * transmit buffer of the port has room, the caller never waits for the UART.
+ *
+ * A command that assigns an attribute (e.g. "t2.txt=...") replaces a pending
+ * command for the same attribute instead of taking a new slot (coalesced).
+ * If all slots are in use, the new command is dropped and end_command()
+ * returns false, the caller can send it again later.
+ *
+ * Texts and numbers are formatted directly into the slot, no String objects
+ * and no heap are used.
+ *
+ * The command terminator (0xFF 0xFF 0xFF) is added on transmission.
+ * *****************************************************************************
+ */
+
+#ifndef NextionQueue_H_
+#define NextionQueue_H_
+
+#include <Arduino.h>
+
+#ifndef NEXTION_QUEUE_DEPTH
+#define NEXTION_QUEUE_DEPTH 12 // number of slots, one is kept free for assembly
+#endif
+
+#ifndef NEXTION_COMMAND_LENGTH
+#define NEXTION_COMMAND_LENGTH 40 // max. characters per command
+#endif
+
+class Nextion_queue {
+
+public:
+  // FUNCTIONS:
+  Nextion_queue(HardwareSerial &serial);
+
+  void begin_command();
+  void print(const char *text);
+  void print(const __FlashStringHelper *text);
+  void print(long value);
+  void print_fixed(long value, byte decimals);
+  bool end_command(); // false = dropped
+
+  void transmit();
+  void discard_pending();
+  bool is_empty();
+
+  byte get_high_water_mark();
+  unsigned long get_dropped_count();
+  unsigned long get_coalesced_count();
+  void reset_statistics();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void append(char character);
+  byte next_slot(byte slot);
+  bool coalesce_with_pending();
+
+  // VARIABLES:
+  HardwareSerial &_serial;
+  char _commands[NEXTION_QUEUE_DEPTH][NEXTION_COMMAND_LENGTH + 1];
+  byte _lengths[NEXTION_QUEUE_DEPTH];
+  byte _head; // slot of the command being assembled
+  byte _tail; // slot of the command being transmitted
+  byte _pending_count;
+  byte _transmit_position;
+  bool _command_overflow;
+
+  byte _high_water_mark;
+  unsigned long _dropped_count;
+  unsigned long _coalesced_count;
+};
+#endif /* NextionQueue_H_ */
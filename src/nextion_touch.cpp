@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * nextion_touch.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "nextion_touch.h"
+
+const byte NEXTION_TOUCH_HEADER = 0x65;
+const byte NEXTION_TERMINATOR = 0xFF;
+const byte NEXTION_EVENT_PUSH = 0x01;
+const byte NEXTION_EVENT_POP = 0x00;
+
+enum parser_state {
+  wait_for_header,
+  read_page,
+  read_component,
+  read_event,
+  read_terminator,
+  skip_frame
+};
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Nextion_touch_parser::Nextion_touch_parser(Stream &serial) : _serial(serial) {
+  memset(_entry_numbers, 0, sizeof(_entry_numbers));
+  _entry_count = 0;
+  _parser_state = wait_for_header;
+  _terminator_count = 0;
+  _event_count = 0;
+  _frame_error_count = 0;
+}
+
+// REGISTER CALLBACKS ----------------------------------------------------------
+// Returns the table entry of a component, a new entry is added if needed:
+int Nextion_touch_parser::get_entry(Nextion_component component) {
+  if (component.page >= NEXTION_MAX_PAGES || component.id >= NEXTION_MAX_COMPONENTS) {
+    return -1;
+  }
+  byte entry_number = _entry_numbers[component.page][component.id];
+  if (entry_number == 0) {
+    if (_entry_count >= NEXTION_MAX_TOUCH_ENTRIES) {
+      return -1;
+    }
+    _entries[_entry_count].push = NULL;
+    _entries[_entry_count].pop = NULL;
+    _entry_count++;
+    entry_number = _entry_count;
+    _entry_numbers[component.page][component.id] = entry_number;
+  }
+  return entry_number - 1;
+}
+
+void Nextion_touch_parser::attach_push(Nextion_component component, Nextion_touch_callback callback) {
+  int entry = get_entry(component);
+  if (entry >= 0) {
+    _entries[entry].push = callback;
+  }
+}
+
+void Nextion_touch_parser::attach_pop(Nextion_component component, Nextion_touch_callback callback) {
+  int entry = get_entry(component);
+  if (entry >= 0) {
+    _entries[entry].pop = callback;
+  }
+}
+
+// PARSE -----------------------------------------------------------------------
+void Nextion_touch_parser::read_events() {
+  int bytes_ready = _serial.available();
+  while (bytes_ready > 0) {
+    parse(_serial.read());
+    bytes_ready--;
+  }
+}
+
+void Nextion_touch_parser::parse(byte data) {
+  switch (_parser_state) {
+
+  case wait_for_header:
+    _terminator_count = 0;
+    if (data == NEXTION_TOUCH_HEADER) {
+      _parser_state = read_page;
+    } else {
+      // Another return frame of the display, skip it:
+      _parser_state = skip_frame;
+      parse(data);
+    }
+    break;
+
+  case read_page:
+    _frame_page = data;
+    _parser_state = read_component;
+    break;
+
+  case read_component:
+    _frame_component = data;
+    _parser_state = read_event;
+    break;
+
+  case read_event:
+    _frame_event = data;
+    _parser_state = read_terminator;
+    break;
+
+  case read_terminator:
+    if (data != NEXTION_TERMINATOR) {
+      _frame_error_count++;
+      _terminator_count = 0; // the frame ends with the next three 0xFF
+      _parser_state = skip_frame;
+      break;
+    }
+    _terminator_count++;
+    if (_terminator_count >= 3) {
+      _parser_state = wait_for_header;
+      dispatch();
+    }
+    break;
+
+  case skip_frame:
+    if (data == NEXTION_TERMINATOR) {
+      _terminator_count++;
+    } else {
+      _terminator_count = 0;
+    }
+    if (_terminator_count >= 3) {
+      _parser_state = wait_for_header;
+    }
+    break;
+  }
+}
+
+// DISPATCH --------------------------------------------------------------------
+void Nextion_touch_parser::dispatch() {
+  if (_frame_page >= NEXTION_MAX_PAGES || _frame_component >= NEXTION_MAX_COMPONENTS) {
+    return;
+  }
+  byte entry_number = _entry_numbers[_frame_page][_frame_component];
+  if (entry_number == 0) {
+    return;
+  }
+  _event_count++;
+
+  Touch_entry &entry = _entries[entry_number - 1];
+  if (_frame_event == NEXTION_EVENT_PUSH && entry.push) {
+    entry.push(NULL);
+  } else if (_frame_event == NEXTION_EVENT_POP && entry.pop) {
+    entry.pop(NULL);
+  }
+}
+
+// STATISTICS ------------------------------------------------------------------
+unsigned long Nextion_touch_parser::get_event_count() { return _event_count; }
+
+unsigned long Nextion_touch_parser::get_frame_error_count() { return _frame_error_count; }
@@ -0,0 +1,84 @@
+/* *****************************************************************************
+ * nextion_touch.h *************************************************************
+ * *****************************************************************************
+ * INCREMENTAL PARSER FOR NEXTION TOUCH EVENTS
+ *
+ * Replaces nexLoop() of the ITEAD library. Every call consumes only the bytes
+ * the serial port has already received and never waits for the rest of a
+ * frame. Complete touch frames
+ *
+ *   0x65 <page> <component> <event> 0xFF 0xFF 0xFF
+ *
+ * are dispatched through a table indexed by page and component id.
+ * All other return frames of the display are skipped.
+ * *****************************************************************************
+ */
+
+#ifndef NextionTouch_H_
+#define NextionTouch_H_
+
+#include <Arduino.h>
+
+#ifndef NEXTION_MAX_PAGES
+#define NEXTION_MAX_PAGES 5
+#endif
+
+#ifndef NEXTION_MAX_COMPONENTS
+#define NEXTION_MAX_COMPONENTS 24 // highest component id + 1
+#endif
+
+#ifndef NEXTION_MAX_TOUCH_ENTRIES
+#define NEXTION_MAX_TOUCH_ENTRIES 32 // components with a callback
+#endif
+
+typedef void (*Nextion_touch_callback)(void *ptr);
+
+struct Nextion_component {
+  byte page;
+  byte id;
+};
+
+class Nextion_touch_parser {
+
+public:
+  // FUNCTIONS:
+  Nextion_touch_parser(Stream &serial);
+
+  void attach_push(Nextion_component component, Nextion_touch_callback callback);
+  void attach_pop(Nextion_component component, Nextion_touch_callback callback);
+
+  void read_events();
+
+  unsigned long get_event_count();
+  unsigned long get_frame_error_count();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void parse(byte data);
+  void dispatch();
+  int get_entry(Nextion_component component);
+
+  // VARIABLES:
+  struct Touch_entry {
+    Nextion_touch_callback push;
+    Nextion_touch_callback pop;
+  };
+
+  Stream &_serial;
+  byte _entry_numbers[NEXTION_MAX_PAGES][NEXTION_MAX_COMPONENTS]; // 0 = none
+  Touch_entry _entries[NEXTION_MAX_TOUCH_ENTRIES];
+  byte _entry_count;
+
+  byte _parser_state;
+  byte _frame_page;
+  byte _frame_component;
+  byte _frame_event;
+  byte _terminator_count;
+
+  unsigned long _event_count;
+  unsigned long _frame_error_count;
+};
+#endif /* NextionTouch_H_ */
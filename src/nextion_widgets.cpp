@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * nextion_widgets.cpp *********************************************************
+ *******************************************************************************/
+
+#include "nextion_widgets.h"
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Nextion_widgets::Nextion_widgets() { _number_of_widgets = 0; }
+
+void Nextion_widgets::setup(const Nextion_widget *table, Nextion_widget_state *states, byte number_of_widgets) {
+  _table = table;
+  _states = states;
+  _number_of_widgets = number_of_widgets;
+  for (byte i = 0; i < _number_of_widgets; i++) {
+    _states[i].is_valid = false;
+  }
+}
+
+void Nextion_widgets::read_widget(byte widget, Nextion_widget &entry) {
+  memcpy_P(&entry, &_table[widget], sizeof(Nextion_widget));
+}
+
+// SEND CHANGED WIDGETS --------------------------------------------------------
+void Nextion_widgets::update(byte page) {
+  unsigned long now = millis();
+  Nextion_widget entry;
+
+  for (byte i = 0; i < _number_of_widgets; i++) {
+    read_widget(i, entry);
+    if (entry.page != page) {
+      continue;
+    }
+    Nextion_widget_state &state = _states[i];
+    if (now - state.last_send_time < entry.min_interval) {
+      continue;
+    }
+    long value = entry.get_value();
+    if (state.is_valid && state.displayed_value == value) {
+      continue;
+    }
+    if (!entry.send(entry.object, value)) {
+      return; // queue full, try again with the next update
+    }
+    state.displayed_value = value;
+    state.last_send_time = now;
+    state.is_valid = true;
+  }
+}
+
+// PAGE CHANGE -----------------------------------------------------------------
+void Nextion_widgets::invalidate_page(byte page) {
+  unsigned long now = millis();
+  Nextion_widget entry;
+
+  for (byte i = 0; i < _number_of_widgets; i++) {
+    read_widget(i, entry);
+    if (entry.page != page) {
+      continue;
+    }
+    Nextion_widget_state &state = _states[i];
+    state.displayed_value = entry.default_value;
+    state.is_valid = entry.keeps_state;
+    state.last_send_time = now - entry.min_interval; // refresh without delay
+  }
+}
+
+// TOUCH EVENTS ----------------------------------------------------------------
+// A touch changes the display without a command, e.g. a dualstate button
+// toggles itself. The callback reports the new state with these functions:
+void Nextion_widgets::set_displayed_value(byte widget, long value) {
+  _states[widget].displayed_value = value;
+  _states[widget].is_valid = true;
+}
+
+void Nextion_widgets::toggle_displayed_value(byte widget) {
+  set_displayed_value(widget, !_states[widget].displayed_value);
+}
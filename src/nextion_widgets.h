@@ -0,0 +1,71 @@
+/* *****************************************************************************
+ * nextion_widgets.h ***********************************************************
+ * *****************************************************************************
+ * REGISTRY OF ALL DISPLAY ITEMS WITH DIRTY TRACKING
+ *
+ * Every item shown on the display is one entry of a constant table (stored in
+ * flash). An entry knows where to get its value from, how to send it and
+ * how often it may be refreshed. The registry remembers the value last sent
+ * and sends an item only if its value has changed. If the transmit queue is
+ * full, the item is not marked as sent and the pass is stopped, the item will
+ * be sent by the next update.
+ *
+ * After a page change, the display shows the values of its page file. Items
+ * that "keep state" (e.g. dualstate buttons that are toggled by "click") then
+ * show their default value, all other items of the page are sent again.
+ * *****************************************************************************
+ */
+
+#ifndef NextionWidgets_H_
+#define NextionWidgets_H_
+
+#include <Arduino.h>
+
+typedef long (*Nextion_widget_getter)();
+typedef bool (*Nextion_widget_sender)(const char *object, long value); // false = not queued
+
+const byte NEXTION_OBJECT_NAME_SIZE = 8;
+
+struct Nextion_widget {
+  byte page;
+  char object[NEXTION_OBJECT_NAME_SIZE]; // object name on the display, e.g. "t2"
+  Nextion_widget_getter get_value;
+  Nextion_widget_sender send;
+  unsigned int min_interval; // [ms]
+  bool keeps_state;
+  long default_value; // value shown after a page change, if keeps_state
+};
+
+struct Nextion_widget_state {
+  long displayed_value;
+  unsigned long last_send_time;
+  bool is_valid;
+};
+
+class Nextion_widgets {
+
+public:
+  // FUNCTIONS:
+  Nextion_widgets();
+
+  void setup(const Nextion_widget *table, Nextion_widget_state *states, byte number_of_widgets);
+
+  void update(byte page);
+  void invalidate_page(byte page);
+
+  void set_displayed_value(byte widget, long value);
+  void toggle_displayed_value(byte widget);
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void read_widget(byte widget, Nextion_widget &entry);
+
+  // VARIABLES:
+  const Nextion_widget *_table; // PROGMEM
+  Nextion_widget_state *_states;
+  byte _number_of_widgets;
+};
+#endif /* NextionWidgets_H_ */
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * pressure_filter.cpp *********************************************************
+ *******************************************************************************/
+
+#include "pressure_filter.h"
+
+// DRUCKSENSOR 0-10V => 0-12bar
+// CONTROLLINO ANALOG INPUT VALUE 0-1023, 30mV per digit (controlino.biz)
+// 10V   => analogRead 333.3 (10V/30mV)
+// 12bar => anlaogRead 333.3
+// 1bar  => analogRead 27.778
+// 1bar  => 1472.6N (Dauertest BXT 3-32 Zylinderkraft.xlsx)
+//
+// Conversion factors from Q8 counts (calmed Q16 >> 8), scaled by 2^16:
+// mbar:   1000 / 27.778 / 256 * 65536 = 9216.1
+// newton: 1472.6 / 27.778 / 256 * 65536 = 13571.4
+const unsigned long Q8_TO_MBAR = 9216;
+const unsigned long Q8_TO_NEWTON = 13571;
+
+const int8_t CALM_SAMPLES = 5;
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Pressure_filter::Pressure_filter() {
+  _smoothed = 0;
+  _calmed = 0;
+  _calm_sum = 0;
+  _calm_counter = 0;
+}
+
+// PROCESS ---------------------------------------------------------------------
+void Pressure_filter::add_sample(int adc_counts) {
+  smoothe_measurement((long)adc_counts << 16);
+  calm_measurement();
+}
+
+// Sum of 2^oversampling_shift ADC values:
+void Pressure_filter::add_oversampled_sample(unsigned int adc_sum, byte oversampling_shift) {
+  smoothe_measurement((long)adc_sum << (16 - oversampling_shift));
+  calm_measurement();
+}
+
+void Pressure_filter::smoothe_measurement(long sample) { //
+  _smoothed = (_smoothed * 4 + sample + 2) / 5; // rounded
+}
+
+void Pressure_filter::calm_measurement() {
+  // A positive calm counter indicates rising pressure.
+  // A negative calm counter indicates dropping pressure.
+
+  // Pressure seems to rise:
+  if (_smoothed > _calmed) {
+    if (_calm_counter >= 0) {
+      _calm_counter++;
+      _calm_sum += _smoothed;
+    } else { // Pressure seemed to drop last time, reset calm counter
+      _calm_counter = 0;
+      _calm_sum = 0;
+    }
+  }
+  // Pressure seems to fall:
+  if (_smoothed < _calmed) {
+    if (_calm_counter <= 0) {
+      _calm_counter--;
+      _calm_sum += _smoothed;
+    } else { // Pressure seemed to rise last time, reset calm counter
+      _calm_counter = 0;
+      _calm_sum = 0;
+    }
+  }
+
+  int8_t samples = abs(_calm_counter);
+  if (samples >= CALM_SAMPLES) {
+    _calmed = (_calm_sum + samples / 2) / samples; // rounded average
+    _calm_counter = 0;
+    _calm_sum = 0;
+  }
+}
+
+// GETTER ----------------------------------------------------------------------
+int Pressure_filter::get_pressure_mbar() { //
+  return ((unsigned long)(_calmed >> 8) * Q8_TO_MBAR) >> 16;
+}
+
+int Pressure_filter::get_force() {
+  int force = ((unsigned long)(_calmed >> 8) * Q8_TO_NEWTON) >> 16;
+
+  // Set last digit zero:
+  force = force / 10;
+  force = force * 10;
+
+  return force;
+}
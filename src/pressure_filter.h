@@ -0,0 +1,49 @@
+/* *****************************************************************************
+ * pressure_filter.h ***********************************************************
+ * *****************************************************************************
+ * PRESSURE SENSOR PROCESSING IN FIXED POINT
+ *
+ * Raw ADC counts => smoothed => calmed => pressure [mbar] and force [N]
+ *
+ * The filters work on ADC counts in Q16 format (counts * 65536), no float math.
+ * Q16 resolves finer than float: the outputs stay within one display digit of
+ * the former float code evaluated exactly (test/test_pressure_filter).
+ * Same filter behaviour as the former float implementation:
+ * - smoothing: smoothed = (smoothed * 4 + sample) / 5
+ * - calming: the value is only updated if there's a higher or lower value
+ *   five times in a row, the new value is the average of these five.
+ * *****************************************************************************
+ */
+
+#ifndef PressureFilter_H_
+#define PressureFilter_H_
+
+#include <Arduino.h>
+
+class Pressure_filter {
+
+public:
+  // FUNCTIONS:
+  Pressure_filter();
+
+  void add_sample(int adc_counts);
+  void add_oversampled_sample(unsigned int adc_sum, byte oversampling_shift);
+
+  int get_pressure_mbar();
+  int get_force(); // [N], last digit zero
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void smoothe_measurement(long sample);
+  void calm_measurement();
+
+  // VARIABLES:
+  long _smoothed; // Q16 counts
+  long _calmed; // Q16 counts
+  long _calm_sum; // Q16 counts
+  int8_t _calm_counter;
+};
+#endif /* PressureFilter_H_ */
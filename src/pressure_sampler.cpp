@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * pressure_sampler.cpp ********************************************************
+ *******************************************************************************/
+
+#include "pressure_sampler.h"
+#ifndef __AVR__
+#include <native_hal.h>
+#endif
+
+const unsigned long TIMER_1_CLOCK = F_CPU / 8; // prescaler 8
+const unsigned long ADC_CLOCK = F_CPU / 128; // prescaler 128
+const unsigned long CONVERSION_RATE = (unsigned long)PRESSURE_SAMPLE_RATE * PRESSURE_OVERSAMPLING;
+
+// An auto triggered conversion takes 13.5 ADC clock cycles (9259 Hz). A
+// trigger during a conversion is lost, the sample rate would drop silently:
+const unsigned long MAX_CONVERSION_RATE = ADC_CLOCK * 2 / 27;
+static_assert(CONVERSION_RATE <= MAX_CONVERSION_RATE,
+              "ADC too slow, reduce PRESSURE_SAMPLE_RATE or PRESSURE_OVERSAMPLING_SHIFT");
+
+static Pressure_sampler *active_sampler = NULL;
+
+#ifndef __AVR__
+static byte active_pin; // converted by the host timer
+static void convert();
+#endif
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Pressure_sampler::Pressure_sampler(byte analog_pin) {
+  _analog_pin = analog_pin;
+  _head = 0;
+  _tail = 0;
+  _sum = 0;
+  _conversion_count = 0;
+  _overrun_count = 0;
+}
+
+// SETUP -----------------------------------------------------------------------
+void Pressure_sampler::begin() {
+  byte channel = _analog_pin >= A0 ? _analog_pin - A0 : _analog_pin;
+  active_sampler = this;
+
+#ifdef __AVR__
+  noInterrupts();
+
+  // TIMER 1, CTC MODE, COMPARE MATCH B TRIGGERS THE ADC:
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS11);
+  OCR1A = TIMER_1_CLOCK / CONVERSION_RATE - 1;
+  OCR1B = OCR1A;
+  TCNT1 = 0;
+  TIMSK1 = 0;
+
+  // ADC, AVCC REFERENCE, AUTO TRIGGER, INTERRUPT, PRESCALER 128:
+  ADMUX = _BV(REFS0) | (channel & 0x07);
+  ADCSRB = (channel & 0x08 ? _BV(MUX5) : 0) | _BV(ADTS2) | _BV(ADTS0);
+  if (channel < 8) {
+    DIDR0 |= _BV(channel); // digital input buffer not needed
+  }
+  ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+
+  interrupts();
+#else
+  (void)channel;
+  active_pin = _analog_pin;
+  native_attach_timer_interrupt(convert, 1000000UL / CONVERSION_RATE);
+#endif
+}
+
+// PRODUCER (ISR) --------------------------------------------------------------
+void Pressure_sampler::add_conversion(unsigned int adc_value) {
+  _sum += adc_value;
+  _conversion_count++;
+  if (_conversion_count < PRESSURE_OVERSAMPLING) {
+    return;
+  }
+
+  byte next_head = (_head + 1) & (PRESSURE_BUFFER_SIZE - 1);
+  if (next_head == _tail) {
+    _overrun_count++; // loop did not consume in time, drop sample
+  } else {
+    _buffer[_head] = _sum;
+    _head = next_head;
+  }
+  _sum = 0;
+  _conversion_count = 0;
+}
+
+#ifdef __AVR__
+ISR(ADC_vect) {
+  TIFR1 = _BV(OCF1B); // clear flag, the next compare match triggers again
+  if (active_sampler) {
+    active_sampler->add_conversion(ADC);
+  }
+}
+#else
+static void convert() {
+  if (active_sampler) {
+    active_sampler->add_conversion(analogRead(active_pin));
+  }
+}
+#endif
+
+// CONSUMER (LOOP) -------------------------------------------------------------
+bool Pressure_sampler::read_sample(unsigned int &adc_sum) {
+  if (_tail == _head) {
+    return false;
+  }
+  adc_sum = _buffer[_tail];
+  _tail = (_tail + 1) & (PRESSURE_BUFFER_SIZE - 1);
+  return true;
+}
+
+unsigned long Pressure_sampler::get_overrun_count() {
+  unsigned long overrun_count;
+  noInterrupts();
+  overrun_count = _overrun_count;
+  interrupts();
+  return overrun_count;
+}
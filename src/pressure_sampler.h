@@ -0,0 +1,63 @@
+/* *****************************************************************************
+ * pressure_sampler.h **********************************************************
+ * *****************************************************************************
+ * TIMER TRIGGERED SAMPLING OF THE PRESSURE SENSOR (ATMEGA2560)
+ *
+ * Timer 1 triggers the ADC in auto trigger mode at a fixed rate, no
+ * analogRead() in the main loop. The ADC interrupt sums up
+ * PRESSURE_OVERSAMPLING conversions and stores every sum in a ring buffer.
+ * The main loop consumes all sums stored since its last visit, so the pressure
+ * filters always see PRESSURE_SAMPLE_RATE samples per second.
+ *
+ * Single producer (ISR) / single consumer (loop), no locking needed.
+ * Uses Timer 1 and the ADC exclusively.
+ * *****************************************************************************
+ */
+
+#ifndef PressureSampler_H_
+#define PressureSampler_H_
+
+#include <Arduino.h>
+
+#ifndef PRESSURE_SAMPLE_RATE
+#define PRESSURE_SAMPLE_RATE 1000 // [Hz] samples after decimation
+#endif
+
+#ifndef PRESSURE_OVERSAMPLING_SHIFT
+#define PRESSURE_OVERSAMPLING_SHIFT 2 // 2 => 4x, 3 => 8x (max. at 1kHz, ADC 9.2kHz)
+#endif
+
+#ifndef PRESSURE_BUFFER_SIZE
+#define PRESSURE_BUFFER_SIZE 32 // power of two
+#endif
+
+const byte PRESSURE_OVERSAMPLING = 1 << PRESSURE_OVERSAMPLING_SHIFT;
+
+class Pressure_sampler {
+
+public:
+  // FUNCTIONS:
+  Pressure_sampler(byte analog_pin);
+
+  void begin();
+  bool read_sample(unsigned int &adc_sum); // sum of PRESSURE_OVERSAMPLING values
+
+  unsigned long get_overrun_count();
+
+  // Called by the ADC interrupt:
+  void add_conversion(unsigned int adc_value);
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // VARIABLES:
+  byte _analog_pin;
+  volatile unsigned int _buffer[PRESSURE_BUFFER_SIZE];
+  volatile byte _head; // written by the ISR only
+  volatile byte _tail; // written by the loop only
+  unsigned int _sum; // ISR only
+  byte _conversion_count; // ISR only
+  volatile unsigned long _overrun_count;
+};
+#endif /* PressureSampler_H_ */
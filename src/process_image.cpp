@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * process_image.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "process_image.h"
+#include <util/atomic.h>
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Process_image::Process_image() {
+  for (byte i = 0; i < PROCESS_IMAGE_PORTS; i++) {
+    _input_masks[i] = 0;
+    _output_masks[i] = 0;
+    _inputs[i] = 0;
+    _outputs[i] = 0;
+  }
+}
+
+void Process_image::add_input(byte port, byte bit_mask) {
+  if (port > 0 && port < PROCESS_IMAGE_PORTS) { // 0 = not a port
+    _input_masks[port] |= bit_mask;
+    *portModeRegister(port) &= ~bit_mask;
+  }
+}
+
+void Process_image::add_output(byte port, byte bit_mask) {
+  if (port > 0 && port < PROCESS_IMAGE_PORTS) { // 0 = not a port
+    _output_masks[port] |= bit_mask;
+    *portOutputRegister(port) &= ~bit_mask; // outputs start low
+    *portModeRegister(port) |= bit_mask;
+  }
+}
+
+// SCAN ------------------------------------------------------------------------
+void Process_image::read_inputs() {
+  for (byte port = 0; port < PROCESS_IMAGE_PORTS; port++) {
+    if (_input_masks[port]) {
+      _inputs[port] = *portInputRegister(port);
+    }
+  }
+}
+
+void Process_image::write_outputs() {
+  for (byte port = 0; port < PROCESS_IMAGE_PORTS; port++) {
+    byte mask = _output_masks[port];
+    if (!mask) {
+      continue;
+    }
+    volatile uint8_t *output_register = portOutputRegister(port);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { // pins of other users stay untouched
+      *output_register = (*output_register & ~mask) | (_outputs[port] & mask);
+    }
+  }
+}
+
+// IMAGE ACCESS ----------------------------------------------------------------
+bool Process_image::get_input(byte port, byte bit_mask) { return _inputs[port] & bit_mask; }
+
+bool Process_image::get_output(byte port, byte bit_mask) { return _outputs[port] & bit_mask; }
+
+void Process_image::set_output(byte port, byte bit_mask, bool state) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (state) {
+      _outputs[port] |= bit_mask;
+    } else {
+      _outputs[port] &= ~bit_mask;
+    }
+  }
+}
+
+void Process_image::write_output_now(byte port, byte bit_mask, bool state) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    set_output(port, bit_mask, state);
+    volatile uint8_t *output_register = portOutputRegister(port);
+    if (state) {
+      *output_register |= bit_mask;
+    } else {
+      *output_register &= ~bit_mask;
+    }
+  }
+}
+
+// INPUT -----------------------------------------------------------------------
+Image_input::Image_input(Process_image &image, byte pin) : _image(image) {
+  _port = digitalPinToPort(pin);
+  _bit_mask = digitalPinToBitMask(pin);
+  _image.add_input(_port, _bit_mask);
+}
+
+bool Image_input::get_state() { return _image.get_input(_port, _bit_mask); }
+
+// OUTPUT ----------------------------------------------------------------------
+Image_output::Image_output(Process_image &image, byte pin) : _image(image) {
+  _port = digitalPinToPort(pin);
+  _bit_mask = digitalPinToBitMask(pin);
+  _image.add_output(_port, _bit_mask);
+}
+
+void Image_output::set(bool state) { _image.set_output(_port, _bit_mask, state); }
+
+void Image_output::toggle() { set(!get_state()); }
+
+bool Image_output::get_state() { return _image.get_output(_port, _bit_mask); }
+
+void Image_output::set_now(bool state) { _image.write_output_now(_port, _bit_mask, state); }
@@ -0,0 +1,95 @@
+/* *****************************************************************************
+ * process_image.h *************************************************************
+ * *****************************************************************************
+ * PLC STYLE PROCESS IMAGE OF THE DIGITAL INPUTS AND OUTPUTS
+ *
+ * read_inputs() latches the input registers of all used ports once at the
+ * start of a scan, Image_input objects return the latched state.
+ * Image_output objects only change the output image, write_outputs() copies
+ * it to the output registers at the end of the scan, one write per port.
+ * All valve changes of a scan therefore happen at the same time.
+ *
+ * set_now() writes one output to its port immediately, for interrupts that
+ * must not wait for the end of the scan (valve scheduler).
+ *
+ * Objects are registered by their constructors, define the Process_image
+ * object before its inputs and outputs.
+ * *****************************************************************************
+ */
+
+#ifndef ProcessImage_H_
+#define ProcessImage_H_
+
+#include <Arduino.h>
+
+#ifndef PROCESS_IMAGE_PORTS
+#define PROCESS_IMAGE_PORTS 13 // Arduino port numbers PA = 1 ... PL = 12
+#endif
+
+class Process_image {
+
+public:
+  // FUNCTIONS:
+  Process_image();
+
+  void read_inputs();
+  void write_outputs();
+
+  // Used by Image_input and Image_output:
+  void add_input(byte port, byte bit_mask);
+  void add_output(byte port, byte bit_mask);
+  bool get_input(byte port, byte bit_mask);
+  bool get_output(byte port, byte bit_mask);
+  void set_output(byte port, byte bit_mask, bool state);
+  void write_output_now(byte port, byte bit_mask, bool state);
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // VARIABLES:
+  byte _input_masks[PROCESS_IMAGE_PORTS];
+  byte _output_masks[PROCESS_IMAGE_PORTS];
+  byte _inputs[PROCESS_IMAGE_PORTS];
+  volatile byte _outputs[PROCESS_IMAGE_PORTS];
+};
+
+class Image_input {
+
+public:
+  // FUNCTIONS:
+  Image_input(Process_image &image, byte pin);
+
+  bool get_state(); // latched at the start of the scan
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // VARIABLES:
+  Process_image &_image;
+  byte _port;
+  byte _bit_mask;
+};
+
+class Image_output {
+
+public:
+  // FUNCTIONS:
+  Image_output(Process_image &image, byte pin);
+
+  void set(bool state); // written at the end of the scan
+  void toggle();
+  bool get_state();
+  void set_now(bool state); // written immediately, also from interrupts
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // VARIABLES:
+  Process_image &_image;
+  byte _port;
+  byte _bit_mask;
+};
+#endif /* ProcessImage_H_ */
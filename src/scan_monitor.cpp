@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * scan_monitor.cpp ************************************************************
+ *******************************************************************************/
+
+#include "scan_monitor.h"
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Scan_monitor::Scan_monitor() { reset(); }
+
+void Scan_monitor::reset() {
+  memset(_scan_counts, 0, sizeof(_scan_counts));
+  memset(_section_counts, 0, sizeof(_section_counts));
+  memset(_worst_section_times, 0, sizeof(_worst_section_times));
+  _worst_scan_time = 0;
+  _worst_scan_section = 0;
+  _scan_is_valid = false;
+}
+
+// MEASURE ---------------------------------------------------------------------
+void Scan_monitor::start_scan() {
+  unsigned long now = micros();
+
+  if (_scan_is_valid) {
+    unsigned long scan_time = now - _scan_start_time;
+    count(_scan_counts[get_bucket(scan_time)]);
+    if (scan_time > _worst_scan_time) {
+      _worst_scan_time = scan_time;
+      _worst_scan_section = _longest_section;
+    }
+  }
+
+  _scan_start_time = now;
+  _section_start_time = now;
+  _longest_section_time = 0;
+  _longest_section = 0;
+  _scan_is_valid = true;
+}
+
+void Scan_monitor::end_section(byte section) {
+  unsigned long now = micros();
+  unsigned long section_time = now - _section_start_time;
+  _section_start_time = now;
+
+  if (!_scan_is_valid || section >= SCAN_MONITOR_MAX_SECTIONS) {
+    return;
+  }
+  count(_section_counts[section][get_bucket(section_time)]);
+  if (section_time > _worst_section_times[section]) {
+    _worst_section_times[section] = section_time;
+  }
+  if (section_time > _longest_section_time) {
+    _longest_section_time = section_time;
+    _longest_section = section;
+  }
+}
+
+// Bucket n holds the times from 2^n to 2^(n+1)-1 [us]:
+byte Scan_monitor::get_bucket(unsigned long time) {
+  byte bucket = 0;
+  while (time > 1 && bucket < SCAN_MONITOR_BUCKETS - 1) {
+    time >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+// Counters stop at their maximum instead of rolling over:
+void Scan_monitor::count(unsigned int &counter) {
+  if (counter < 0xFFFF) {
+    counter++;
+  }
+}
+
+// GETTER ----------------------------------------------------------------------
+unsigned int Scan_monitor::get_scan_count(byte bucket) { return _scan_counts[bucket]; }
+
+unsigned int Scan_monitor::get_section_count(byte section, byte bucket) { return _section_counts[section][bucket]; }
+
+unsigned long Scan_monitor::get_worst_scan_time() { return _worst_scan_time; }
+
+byte Scan_monitor::get_worst_scan_section() { return _worst_scan_section; }
+
+unsigned long Scan_monitor::get_worst_section_time(byte section) { return _worst_section_times[section]; }
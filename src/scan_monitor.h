@@ -0,0 +1,67 @@
+/* *****************************************************************************
+ * scan_monitor.h **************************************************************
+ * *****************************************************************************
+ * SCAN TIME HISTOGRAM OF THE MAIN LOOP
+ *
+ * start_scan() is called at the beginning of every loop, end_section() after
+ * every part of the loop. The time of the scan and of every section is
+ * counted in a histogram with logarithmic buckets:
+ *
+ *   bucket 0: 0..1us, bucket 1: 2..3us, bucket 2: 4..7us, ... (2^n us)
+ *
+ * The longest scan is kept with the section that took most of its time.
+ * Costs one micros() call per section and one per scan, no floating point.
+ * *****************************************************************************
+ */
+
+#ifndef ScanMonitor_H_
+#define ScanMonitor_H_
+
+#include <Arduino.h>
+
+#ifndef SCAN_MONITOR_MAX_SECTIONS
+#define SCAN_MONITOR_MAX_SECTIONS 6
+#endif
+
+#ifndef SCAN_MONITOR_BUCKETS
+#define SCAN_MONITOR_BUCKETS 16 // last bucket counts everything >= 2^15us
+#endif
+
+class Scan_monitor {
+
+public:
+  // FUNCTIONS:
+  Scan_monitor();
+
+  void start_scan();
+  void end_section(byte section);
+  void reset(); // the running scan is not counted
+
+  unsigned int get_scan_count(byte bucket);
+  unsigned int get_section_count(byte section, byte bucket);
+  unsigned long get_worst_scan_time(); // [us]
+  byte get_worst_scan_section(); // section with the longest time of that scan
+  unsigned long get_worst_section_time(byte section); // [us]
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  byte get_bucket(unsigned long time);
+  void count(unsigned int &counter);
+
+  // VARIABLES:
+  unsigned int _scan_counts[SCAN_MONITOR_BUCKETS];
+  unsigned int _section_counts[SCAN_MONITOR_MAX_SECTIONS][SCAN_MONITOR_BUCKETS];
+  unsigned long _worst_section_times[SCAN_MONITOR_MAX_SECTIONS];
+  unsigned long _worst_scan_time;
+  byte _worst_scan_section;
+
+  unsigned long _scan_start_time;
+  unsigned long _section_start_time;
+  unsigned long _longest_section_time; // of the running scan
+  byte _longest_section;
+  bool _scan_is_valid;
+};
+#endif /* ScanMonitor_H_ */
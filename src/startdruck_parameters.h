@@ -0,0 +1,34 @@
+/* *****************************************************************************
+ * startdruck_parameters.h *****************************************************
+ * *****************************************************************************
+ * PARAMETERS OF THE STEP "STARTDRUCK" (PRESSURE OF THE PNEUMATIC SPRING)
+ *
+ * The step fills the 800mm cylinder with pulses until the force reaches the
+ * startfuelldruck, and confirms it a number of times before it completes.
+ * Fixed pulses last the fill time and are followed by the wait time. Adaptive
+ * pulses are sized by the fill controller, each is followed by the settle
+ * time (see fill_controller.h).
+ *
+ * The values are defined in main.cpp. They can be tuned offline with the
+ * host simulator (sim/startdruck_sweep.cpp).
+ * *****************************************************************************
+ */
+
+#ifndef StartdruckParameters_H_
+#define StartdruckParameters_H_
+
+#include <Arduino.h>
+
+struct Startdruck_parameters {
+  unsigned int fill_time; // [ms] minimum duration of a fill pulse
+  unsigned int wait_time; // [ms] minimum wait between two pulses
+  byte confirmations; // times the force has to be reached in a row
+  int minimum_inflation; // [N] fill as long as the force is this far below the target
+  bool is_adaptive; // fixed pulses if false or if the fill controller fails
+  unsigned int settle_time; // [ms] adaptive: wait after a pulse
+  byte adaptive_confirmations;
+};
+
+extern Startdruck_parameters startdruck_parameters;
+
+#endif /* StartdruckParameters_H_ */
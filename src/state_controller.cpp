@@ -4,43 +4,78 @@
 
 #include "state_controller.h"
 
+// TRANSITION TABLE ------------------------------------------------------------
+// New mode for every [mode][event]:
+const byte mode_transitions[end_of_mode_enum][end_of_mode_event_enum] PROGMEM = {
+    // set step, set auto, set error, set reset, toggle step/auto
+    {step_mode, auto_mode, error_mode, reset_mode, auto_mode}, // step_mode
+    {step_mode, auto_mode, error_mode, reset_mode, step_mode}, // auto_mode
+    {step_mode, auto_mode, error_mode, reset_mode, auto_mode}, // error_mode
+    {step_mode, auto_mode, error_mode, reset_mode, auto_mode}, // reset_mode
+};
+
 // CONSTRUCTORS ----------------------------------------------------------------
-State_controller::State_controller(int number_of_steps) { _number_of_main_cycle_steps = number_of_steps; }
-State_controller::State_controller() {}
+State_controller::State_controller(int number_of_steps) : State_controller() {
+  _number_of_main_cycle_steps = number_of_steps;
+}
+State_controller::State_controller() {
+  _number_of_main_cycle_steps = 0;
+  _current_main_cycle_step = 0;
+  _previous_cycle_step = 0;
+  _mode = step_mode;
+  _machine_running = false;
+  _run_after_reset = false;
+  _log_head = 0;
+  _log_count = 0;
+}
 
 void State_controller::set_no_of_steps(int number_of_steps) { _number_of_main_cycle_steps = number_of_steps; }
 
-// STEP MODE -------------------------------------------------------------------
-void State_controller::set_step_mode() {
-  _step_mode = true;
-  _auto_mode = false;
-  _reset_mode = false;
-  _error_mode = false;
+// MODE TRANSITIONS ------------------------------------------------------------
+void State_controller::handle_event(byte event) {
+  if (event >= end_of_mode_event_enum) {
+    return;
+  }
+  byte previous_mode = _mode;
+  _mode = pgm_read_byte(&mode_transitions[previous_mode][event]);
+  if (_mode != previous_mode) {
+    log_transition(previous_mode, event);
+  }
 }
-bool State_controller::is_in_step_mode() { return _step_mode; }
 
-// AUTO MODE -------------------------------------------------------------------
-void State_controller::set_auto_mode() {
-  _step_mode = false;
-  _auto_mode = true;
-  _reset_mode = false;
-  _error_mode = false;
+byte State_controller::get_mode() { return _mode; }
+
+void State_controller::log_transition(byte previous_mode, byte event) {
+  Mode_transition &entry = _log[_log_head];
+  entry.time = millis();
+  entry.previous_mode = previous_mode;
+  entry.event = event;
+  entry.mode = _mode;
+  _log_head = (_log_head + 1) % MODE_LOG_SIZE;
+  if (_log_count < MODE_LOG_SIZE) {
+    _log_count++;
+  }
 }
-bool State_controller::is_in_auto_mode() { return _auto_mode; }
 
-// RESET MODE ------------------------------------------------------------------
-void State_controller::set_reset_mode() {
-  _step_mode = false;
-  _auto_mode = false;
-  _reset_mode = true;
-  _error_mode = false;
-}
+byte State_controller::get_number_of_logged_transitions() { return _log_count; }
 
-bool State_controller::is_in_reset_mode() {
-  bool reset_mode = _reset_mode;
-  return reset_mode;
+Mode_transition State_controller::get_logged_transition(byte age) {
+  return _log[(_log_head + MODE_LOG_SIZE - 1 - age) % MODE_LOG_SIZE];
 }
 
+// STEP MODE -------------------------------------------------------------------
+void State_controller::set_step_mode() { handle_event(event_set_step_mode); }
+bool State_controller::is_in_step_mode() { return _mode == step_mode; }
+
+// AUTO MODE -------------------------------------------------------------------
+void State_controller::set_auto_mode() { handle_event(event_set_auto_mode); }
+bool State_controller::is_in_auto_mode() { return _mode == auto_mode; }
+
+// RESET MODE ------------------------------------------------------------------
+void State_controller::set_reset_mode() { handle_event(event_set_reset_mode); }
+
+bool State_controller::is_in_reset_mode() { return _mode == reset_mode; }
+
 void State_controller::set_run_after_reset(bool run_after_reset) { _run_after_reset = run_after_reset; }
 
 bool State_controller::run_after_reset_is_active() {
@@ -49,14 +84,9 @@ bool State_controller::run_after_reset_is_active() {
 }
 
 // ERROR MODE -------------------------------------------------------------
-void State_controller::set_error_mode() {
-  _step_mode = false;
-  _auto_mode = false;
-  _reset_mode = false;
-  _error_mode = true;
-}
+void State_controller::set_error_mode() { handle_event(event_set_error_mode); }
 
-bool State_controller::is_in_error_mode() { return _error_mode; }
+bool State_controller::is_in_error_mode() { return _mode == error_mode; }
 
 // MACHINE RUNNING -------------------------------------------------------------
 
@@ -68,13 +98,7 @@ void State_controller::set_machine_stop() { _machine_running = false; }
 
 void State_controller::toggle_machine_running_state() { _machine_running = !_machine_running; }
 
-void State_controller::toggle_step_auto_mode() {
-  if (is_in_auto_mode()) {
-    set_step_mode();
-  } else {
-    set_auto_mode();
-  }
-}
+void State_controller::toggle_step_auto_mode() { handle_event(event_toggle_step_auto_mode); }
 
 bool State_controller::machine_is_running() {
   bool machineRunning = _machine_running;
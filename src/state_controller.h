@@ -9,6 +9,10 @@
  * 4) reset mode
  *
  * Status "machine_is_running" is set independently.
+ *
+ * The mode is one byte. Every mode change is an event, the transition table
+ * (stored in flash) gives the new mode for every mode and event. The last
+ * MODE_LOG_SIZE mode changes are logged with their time.
  * 
  * *****************************************************************************
  */
@@ -16,6 +20,36 @@
 #ifndef StateController_H_
 #define StateController_H_
 
+#include <Arduino.h>
+
+#ifndef MODE_LOG_SIZE
+#define MODE_LOG_SIZE 8
+#endif
+
+enum machine_mode {
+  step_mode,
+  auto_mode,
+  error_mode,
+  reset_mode,
+  end_of_mode_enum
+};
+
+enum mode_event {
+  event_set_step_mode,
+  event_set_auto_mode,
+  event_set_error_mode,
+  event_set_reset_mode,
+  event_toggle_step_auto_mode,
+  end_of_mode_event_enum
+};
+
+struct Mode_transition {
+  unsigned long time; // [ms]
+  byte previous_mode;
+  byte event;
+  byte mode;
+};
+
 class State_controller {
 
 public:
@@ -25,6 +59,9 @@ public:
 
   void set_no_of_steps(int number_of_steps);
 
+  void handle_event(byte event);
+  byte get_mode();
+
   void set_step_mode();
   bool is_in_step_mode();
 
@@ -53,22 +90,26 @@ public:
   int get_current_step();
   bool step_switch_has_happend();
 
+  byte get_number_of_logged_transitions();
+  Mode_transition get_logged_transition(byte age); // 0 = latest
+
   // VARIABLES:
   // n.a.
 
 private:
   // FUNCTIONS:
-  // n.a.
+  void log_transition(byte previous_mode, byte event);
 
   // VARIABLES:
   int _number_of_main_cycle_steps;
   int _current_main_cycle_step;
   int _previous_cycle_step;
+  byte _mode;
   bool _machine_running;
-  bool _step_mode;
-  bool _auto_mode;
-  bool _reset_mode;
   bool _run_after_reset;
-  bool _error_mode;
+
+  Mode_transition _log[MODE_LOG_SIZE];
+  byte _log_head; // next entry
+  byte _log_count;
 };
 #endif /* StateController_H_ */
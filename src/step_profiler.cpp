@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * step_profiler.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "step_profiler.h"
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Step_profiler::Step_profiler() {
+  memset(_entry_times, 0, sizeof(_entry_times));
+  reset();
+}
+
+void Step_profiler::reset() { memset(_timings, 0, sizeof(_timings)); }
+
+// MEASURE ---------------------------------------------------------------------
+void Step_profiler::step_entered(byte step) {
+  if (step < STEP_PROFILER_MAX_STEPS) {
+    _entry_times[step] = millis();
+  }
+}
+
+void Step_profiler::step_completed(byte step) {
+  if (step >= STEP_PROFILER_MAX_STEPS) {
+    return;
+  }
+  unsigned long duration = millis() - _entry_times[step];
+  Step_timing &timing = _timings[step];
+
+  if (timing.count == 0 || duration < timing.min) {
+    timing.min = duration;
+  }
+  if (duration > timing.max) {
+    timing.max = duration;
+  }
+  timing.last = duration;
+
+  // Halve sum and count before they could overflow, the mean stays the same:
+  if (timing.count == 0xFFFF || timing.sum + duration < timing.sum) {
+    timing.sum /= 2;
+    timing.count /= 2;
+  }
+  timing.sum += duration;
+  timing.count++;
+}
+
+// GETTER ----------------------------------------------------------------------
+unsigned long Step_profiler::get_last_duration(byte step) { return _timings[step].last; }
+
+unsigned long Step_profiler::get_min_duration(byte step) { return _timings[step].min; }
+
+unsigned long Step_profiler::get_mean_duration(byte step) {
+  Step_timing &timing = _timings[step];
+  if (timing.count == 0) {
+    return 0;
+  }
+  return (timing.sum + timing.count / 2) / timing.count;
+}
+
+unsigned long Step_profiler::get_max_duration(byte step) { return _timings[step].max; }
+
+unsigned int Step_profiler::get_completion_count(byte step) { return _timings[step].count; }
@@ -0,0 +1,56 @@
+/* *****************************************************************************
+ * step_profiler.h *************************************************************
+ * *****************************************************************************
+ * DURATION STATISTICS OF THE CYCLE STEPS
+ *
+ * A step is entered when its initial stuff is done and left when it reports
+ * to be completed. For every step, the last, shortest, mean and longest
+ * duration is kept in a small RAM table.
+ *
+ * Durations are wall clock times [ms], a step interrupted by a machine stop
+ * includes the stopped time. Steps may overlap (see Step_overlap).
+ * *****************************************************************************
+ */
+
+#ifndef StepProfiler_H_
+#define StepProfiler_H_
+
+#include <Arduino.h>
+
+#ifndef STEP_PROFILER_MAX_STEPS
+#define STEP_PROFILER_MAX_STEPS 16
+#endif
+
+class Step_profiler {
+
+public:
+  // FUNCTIONS:
+  Step_profiler();
+
+  void step_entered(byte step);
+  void step_completed(byte step);
+  void reset();
+
+  unsigned long get_last_duration(byte step);
+  unsigned long get_min_duration(byte step);
+  unsigned long get_mean_duration(byte step);
+  unsigned long get_max_duration(byte step);
+  unsigned int get_completion_count(byte step);
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // VARIABLES:
+  struct Step_timing {
+    unsigned long last;
+    unsigned long min;
+    unsigned long max;
+    unsigned long sum;
+    unsigned int count;
+  };
+
+  Step_timing _timings[STEP_PROFILER_MAX_STEPS];
+  unsigned long _entry_times[STEP_PROFILER_MAX_STEPS];
+};
+#endif /* StepProfiler_H_ */
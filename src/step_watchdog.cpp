@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * step_watchdog.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "step_watchdog.h"
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Step_watchdog::Step_watchdog(Cycle_step_engine &engine) : _engine(engine) {
+  _table = NULL;
+  memset(_limits, 0, sizeof(_limits));
+  memset(_elapsed, 0, sizeof(_elapsed));
+  _last_update_time = 0;
+  _has_fired = false;
+  _fault_step = 0;
+  _fault_duration = 0;
+  _fault_count = 0;
+}
+
+void Step_watchdog::setup(const Step_timeout *table) {
+  _table = table;
+  for (byte step = 0; step < _engine.get_number_of_steps(); step++) {
+    set_limit(step, 0);
+  }
+  _last_update_time = millis();
+}
+
+void Step_watchdog::read_entry(byte step, Step_timeout &entry) {
+  memcpy_P(&entry, &_table[step], sizeof(Step_timeout));
+}
+
+void Step_watchdog::set_limit(byte step, unsigned int limit) {
+  if (limit == 0) {
+    Step_timeout entry;
+    read_entry(step, entry);
+    limit = entry.limit;
+  }
+  _limits[step] = limit;
+}
+
+// WATCH -----------------------------------------------------------------------
+void Step_watchdog::update(bool machine_is_running) {
+  unsigned long now = millis();
+  unsigned long elapsed_time = now - _last_update_time;
+  _last_update_time = now;
+
+  for (byte step = 0; step < _engine.get_number_of_steps(); step++) {
+    if (!_engine.is_started(step)) {
+      _elapsed[step] = 0;
+      continue;
+    }
+    if (!machine_is_running) {
+      continue;
+    }
+    _elapsed[step] += elapsed_time;
+    if (_limits[step] && _elapsed[step] > _limits[step] && !_has_fired) {
+      _has_fired = true;
+      _fault_step = step;
+      _fault_duration = _elapsed[step];
+      _fault_count++;
+    }
+  }
+}
+
+// This is a "one time flag", state will be reseted after fist inquiry:
+bool Step_watchdog::has_fired() {
+  if (_has_fired) {
+    _has_fired = false;
+    memset(_elapsed, 0, sizeof(_elapsed));
+    return true;
+  }
+  return false;
+}
+
+// GETTER ----------------------------------------------------------------------
+unsigned int Step_watchdog::get_expected_duration(byte step) {
+  Step_timeout entry;
+  read_entry(step, entry);
+  return entry.expected;
+}
+
+unsigned int Step_watchdog::get_limit(byte step) { return _limits[step]; }
+
+byte Step_watchdog::get_fault_step() { return _fault_step; }
+
+unsigned long Step_watchdog::get_fault_duration() { return _fault_duration; }
+
+unsigned int Step_watchdog::get_fault_count() { return _fault_count; }
@@ -0,0 +1,64 @@
+/* *****************************************************************************
+ * step_watchdog.h *************************************************************
+ * *****************************************************************************
+ * TIMEOUT OF EVERY SINGLE CYCLE STEP
+ *
+ * Every step carries an expected duration and its own timeout limit (table in
+ * flash, order = step table). The limit can be overridden per step, e.g. by a
+ * value stored in the eeprom. A step with limit 0 is not watched (e.g. a pause
+ * with its own timer).
+ *
+ * Only the time while the machine is running is counted, from the initial
+ * stuff of a step until it is completed. Steps running in parallel are
+ * watched independently. The watchdog fires once, for the first step that
+ * exceeds its limit, and keeps the step and the time it took.
+ * *****************************************************************************
+ */
+
+#ifndef StepWatchdog_H_
+#define StepWatchdog_H_
+
+#include <Arduino.h>
+#include <cycle_step.h>
+
+struct Step_timeout {
+  unsigned int expected; // [ms]
+  unsigned int limit; // [ms] 0 = not watched
+};
+
+class Step_watchdog {
+
+public:
+  // FUNCTIONS:
+  Step_watchdog(Cycle_step_engine &engine);
+  void setup(const Step_timeout *table); // PROGMEM
+
+  void set_limit(byte step, unsigned int limit); // [ms] 0 = limit of the table
+  void update(bool machine_is_running);
+  bool has_fired(); // one time flag
+
+  unsigned int get_expected_duration(byte step);
+  unsigned int get_limit(byte step);
+  byte get_fault_step();
+  unsigned long get_fault_duration(); // [ms]
+  unsigned int get_fault_count();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void read_entry(byte step, Step_timeout &entry);
+
+  // VARIABLES:
+  Cycle_step_engine &_engine;
+  const Step_timeout *_table; // PROGMEM
+  unsigned int _limits[MAX_CYCLE_STEPS];
+  unsigned long _elapsed[MAX_CYCLE_STEPS]; // [ms] running time of the step
+  unsigned long _last_update_time;
+  bool _has_fired;
+  byte _fault_step;
+  unsigned long _fault_duration;
+  unsigned int _fault_count;
+};
+#endif /* StepWatchdog_H_ */
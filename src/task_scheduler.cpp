@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * task_scheduler.cpp **********************************************************
+ *******************************************************************************/
+
+#include "task_scheduler.h"
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Task_scheduler::Task_scheduler() {
+  _number_of_tasks = 0;
+  _tick_millis = 0;
+  _tick_micros = 0;
+}
+
+void Task_scheduler::setup(const Scheduled_task *table, Scheduled_task_state *states, byte number_of_tasks) {
+  _table = table;
+  _states = states;
+  _number_of_tasks = min(number_of_tasks, (byte)TASK_SCHEDULER_MAX_TASKS);
+  unsigned long now = millis();
+  for (byte i = 0; i < _number_of_tasks; i++) {
+    _states[i].next_due_time = now; // all tasks are due at the first tick
+  }
+  reset_statistics();
+}
+
+void Task_scheduler::read_task(byte task, Scheduled_task &entry) {
+  memcpy_P(&entry, &_table[task], sizeof(Scheduled_task));
+}
+
+// RUN DUE TASKS ---------------------------------------------------------------
+void Task_scheduler::tick() {
+  _tick_millis = millis();
+  _tick_micros = micros();
+
+  unsigned int tasks_done = 0; // one bit per task
+  while (true) {
+    int task = get_next_due_task(tasks_done);
+    if (task < 0) {
+      return;
+    }
+    run_task(task);
+    tasks_done |= 1 << task;
+
+    // Tick budget used up, the remaining tasks stay due:
+    if (micros() - _tick_micros >= TASK_SCHEDULER_TICK_BUDGET) {
+      return;
+    }
+  }
+}
+
+// Returns the due task with the highest priority, -1 if no task is due:
+int Task_scheduler::get_next_due_task(unsigned int tasks_done) {
+  int next_task = -1;
+  byte next_priority = 0xFF;
+  Scheduled_task entry;
+
+  for (byte i = 0; i < _number_of_tasks; i++) {
+    if (tasks_done & (1 << i)) {
+      continue;
+    }
+    if ((long)(_tick_millis - _states[i].next_due_time) < 0) {
+      continue; // not due yet
+    }
+    read_task(i, entry);
+    if (next_task < 0 || entry.priority < next_priority) {
+      next_task = i;
+      next_priority = entry.priority;
+    }
+  }
+  return next_task;
+}
+
+void Task_scheduler::run_task(byte task) {
+  Scheduled_task entry;
+  read_task(task, entry);
+  Scheduled_task_state &state = _states[task];
+
+  // Missed periods are not caught up, the task keeps its cadence from now on:
+  if (_tick_millis - state.next_due_time >= entry.period) {
+    if (state.late_count < 0xFFFF) {
+      state.late_count++;
+    }
+    state.next_due_time = _tick_millis + entry.period;
+  } else {
+    state.next_due_time += entry.period;
+  }
+
+  unsigned long start_time = micros();
+  entry.run();
+  unsigned long run_time = micros() - start_time;
+
+  if (run_time > state.worst_run_time) {
+    state.worst_run_time = run_time;
+  }
+  if (run_time > entry.budget && state.overrun_count < 0xFFFF) {
+    state.overrun_count++;
+  }
+}
+
+// Nothing runs before this time, the loop may as well sleep until then:
+unsigned long Task_scheduler::get_next_due_time() {
+  unsigned long now = millis();
+  unsigned long next_due_time = now + 0xFFFF;
+  for (byte i = 0; i < _number_of_tasks; i++) {
+    if ((long)(_states[i].next_due_time - next_due_time) < 0) {
+      next_due_time = _states[i].next_due_time;
+    }
+  }
+  return next_due_time;
+}
+
+// STATISTICS ------------------------------------------------------------------
+unsigned long Task_scheduler::get_tick_millis() { return _tick_millis; }
+
+unsigned long Task_scheduler::get_tick_micros() { return _tick_micros; }
+
+unsigned int Task_scheduler::get_late_count(byte task) { return _states[task].late_count; }
+
+unsigned int Task_scheduler::get_overrun_count(byte task) { return _states[task].overrun_count; }
+
+unsigned long Task_scheduler::get_worst_run_time(byte task) { return _states[task].worst_run_time; }
+
+void Task_scheduler::reset_statistics() {
+  for (byte i = 0; i < _number_of_tasks; i++) {
+    _states[i].worst_run_time = 0;
+    _states[i].late_count = 0;
+    _states[i].overrun_count = 0;
+  }
+}
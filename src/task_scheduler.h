@@ -0,0 +1,82 @@
+/* *****************************************************************************
+ * task_scheduler.h ************************************************************
+ * *****************************************************************************
+ * COOPERATIVE FIXED PERIOD TASK SCHEDULER
+ *
+ * Every task of the constant task table (stored in flash) has a period, a
+ * priority and a time budget. tick() takes one time snapshot and runs the due
+ * tasks, highest priority (0) first. As soon as the tick has used up
+ * TASK_SCHEDULER_TICK_BUDGET, the remaining due tasks wait for the next tick,
+ * so a slow task of low priority cannot delay the tasks of high priority.
+ *
+ * Statistics per task:
+ * - late: the task started a full period or more after it was due
+ * - overrun: the task ran longer than its budget
+ * *****************************************************************************
+ */
+
+#ifndef TaskScheduler_H_
+#define TaskScheduler_H_
+
+#include <Arduino.h>
+
+#ifndef TASK_SCHEDULER_MAX_TASKS
+#define TASK_SCHEDULER_MAX_TASKS 8
+#endif
+
+#ifndef TASK_SCHEDULER_TICK_BUDGET
+#define TASK_SCHEDULER_TICK_BUDGET 1000 // [us]
+#endif
+
+typedef void (*Scheduled_task_function)();
+
+struct Scheduled_task {
+  Scheduled_task_function run;
+  unsigned int period; // [ms]
+  byte priority; // 0 = highest
+  unsigned int budget; // [us]
+};
+
+struct Scheduled_task_state {
+  unsigned long next_due_time;
+  unsigned long worst_run_time;
+  unsigned int late_count;
+  unsigned int overrun_count;
+};
+
+class Task_scheduler {
+
+public:
+  // FUNCTIONS:
+  Task_scheduler();
+
+  void setup(const Scheduled_task *table, Scheduled_task_state *states, byte number_of_tasks);
+  void tick();
+
+  unsigned long get_tick_millis(); // time snapshot of the running tick
+  unsigned long get_tick_micros();
+  unsigned long get_next_due_time(); // [ms] earliest due time of all tasks
+
+  unsigned int get_late_count(byte task);
+  unsigned int get_overrun_count(byte task);
+  unsigned long get_worst_run_time(byte task); // [us]
+  void reset_statistics();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void read_task(byte task, Scheduled_task &entry);
+  int get_next_due_task(unsigned int tasks_done);
+  void run_task(byte task);
+
+  // VARIABLES:
+  const Scheduled_task *_table; // PROGMEM
+  Scheduled_task_state *_states;
+  byte _number_of_tasks;
+
+  unsigned long _tick_millis;
+  unsigned long _tick_micros;
+};
+#endif /* TaskScheduler_H_ */
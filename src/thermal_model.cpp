@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * thermal_model.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "thermal_model.h"
+
+const unsigned long Q16_ONE = 65536;
+const long MAX_TEMPERATURE = 60000; // [0.1K] keeps the fixed point products within 32 bits
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Thermal_model::Thermal_model() {
+  _temperature = 0;
+  _last_update_time = 0;
+  _last_weld_time = 0;
+  _last_pause = 0;
+}
+
+void Thermal_model::set_temperature(long temperature) {
+  _temperature = constrain(temperature, 0L, MAX_TEMPERATURE);
+  _last_update_time = millis();
+}
+
+// MODEL -----------------------------------------------------------------------
+// exp(-seconds / time_constant) by squaring of the decay of one second:
+unsigned long Thermal_model::get_decay_factor(unsigned long seconds) {
+  unsigned long time_constant = max(thermal_parameters.time_constant, 1U);
+  unsigned long factor = Q16_ONE - (Q16_ONE + time_constant - 1) / time_constant;
+  unsigned long result = Q16_ONE;
+  while (seconds > 0) {
+    if (seconds & 1) {
+      result = (result * factor + Q16_ONE - 1) >> 16;
+    }
+    factor = (factor * factor + Q16_ONE - 1) >> 16;
+    seconds >>= 1;
+  }
+  return result;
+}
+
+long Thermal_model::get_decayed(long temperature, unsigned long seconds) {
+  return (temperature * get_decay_factor(seconds) + Q16_ONE - 1) >> 16;
+}
+
+long Thermal_model::get_weld_heat(unsigned long weld_time) {
+  return weld_time * thermal_parameters.heating_rate / 1000;
+}
+
+void Thermal_model::cool_down() {
+  unsigned long seconds = (millis() - _last_update_time) / 1000;
+  _temperature = get_decayed(_temperature, seconds);
+  _last_update_time += seconds * 1000;
+}
+
+// The weld heats the tool, its cooling during the weld is neglected:
+void Thermal_model::add_weld(unsigned long weld_time) {
+  cool_down();
+  _temperature = min(_temperature + get_weld_heat(weld_time), MAX_TEMPERATURE);
+  _last_weld_time = weld_time;
+}
+
+// Shortest pause after which the next weld (as long as the last one) stays
+// below the limit, found by bisection:
+unsigned int Thermal_model::get_required_pause() {
+  cool_down();
+  long allowed = (long)thermal_parameters.temperature_limit - get_weld_heat(_last_weld_time);
+  unsigned int pause = 0;
+  if (_temperature > allowed) {
+    unsigned int shortest = 1;
+    unsigned int longest = THERMAL_MODEL_MAX_PAUSE;
+    while (shortest < longest) {
+      unsigned int middle = (shortest + longest) / 2;
+      if (get_decayed(_temperature, middle) > allowed) {
+        shortest = middle + 1;
+      } else {
+        longest = middle;
+      }
+    }
+    pause = shortest; // the maximum pause, if the limit can't be reached
+  }
+  _last_pause = pause;
+  return pause;
+}
+
+// GETTER ----------------------------------------------------------------------
+long Thermal_model::get_temperature() { return _temperature; }
+
+unsigned int Thermal_model::get_last_pause() { return _last_pause; }
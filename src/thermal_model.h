@@ -0,0 +1,68 @@
+/* *****************************************************************************
+ * thermal_model.h *************************************************************
+ * *****************************************************************************
+ * FIRST ORDER THERMAL MODEL OF THE WELDING TOOL
+ *
+ * The tool temperature is kept as rise above ambient [0.1K]. Every weld heats
+ * the tool proportional to its measured duration, between the welds the
+ * temperature decays exponentially with the time constant of the tool:
+ *
+ *   temperature = temperature * exp(-elapsed / time_constant)
+ *
+ * The decay is calculated in whole seconds in fixed point (Q16), rounded up,
+ * so the model never estimates the tool cooler than the exact solution.
+ *
+ * get_required_pause() returns the shortest pause that keeps the temperature
+ * below the limit during the next weld. The state is persisted by the caller
+ * (eeprom), after a reset the model starts with the stored temperature.
+ *
+ * The parameters are defined in main.cpp.
+ * *****************************************************************************
+ */
+
+#ifndef ThermalModel_H_
+#define ThermalModel_H_
+
+#include <Arduino.h>
+
+#define THERMAL_MODEL_MAX_PAUSE 600 // [s] same as the fixed cooldown time
+
+struct Thermal_parameters {
+  bool is_adaptive; // false: fixed cooldown after cycles_in_a_row
+  unsigned int heating_rate; // [0.1K per s of weld]
+  unsigned int time_constant; // [s]
+  unsigned int temperature_limit; // [0.1K] above ambient
+};
+
+extern Thermal_parameters thermal_parameters;
+
+class Thermal_model {
+
+public:
+  // FUNCTIONS:
+  Thermal_model();
+
+  void set_temperature(long temperature); // [0.1K], e.g. from the eeprom
+  void add_weld(unsigned long weld_time); // [ms]
+  void cool_down(); // until now
+
+  long get_temperature(); // [0.1K]
+  unsigned int get_required_pause(); // [s] before the next weld
+  unsigned int get_last_pause(); // [s]
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  unsigned long get_decay_factor(unsigned long seconds); // Q16
+  long get_decayed(long temperature, unsigned long seconds);
+  long get_weld_heat(unsigned long weld_time);
+
+  // VARIABLES:
+  long _temperature;
+  unsigned long _last_update_time; // [ms]
+  unsigned long _last_weld_time; // [ms]
+  unsigned int _last_pause;
+};
+#endif /* ThermalModel_H_ */
@@ -0,0 +1,178 @@
+/*******************************************************************************
+ * valve_scheduler.cpp *********************************************************
+ *******************************************************************************/
+
+#include "valve_scheduler.h"
+#include <util/atomic.h>
+#ifndef __AVR__
+#include <native_hal.h>
+#endif
+
+const unsigned long MICROS_PER_TICK = 64000000UL / F_CPU; // prescaler 64
+const unsigned long MAX_COMPARE_STEP = 50000; // [ticks] 200ms, within 16 bit
+const unsigned long MIN_COMPARE_STEP = 10; // [ticks] compare must lie ahead of the counter
+
+static Valve_scheduler *active_scheduler = NULL;
+
+#ifndef __AVR__
+const unsigned long NATIVE_VALVE_TIMER_PERIOD = 100; // [us]
+static void switch_due_valves_of_active_scheduler();
+#endif
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Valve_scheduler::Valve_scheduler() {
+  for (byte i = 0; i < VALVE_SCHEDULER_MAX_EVENTS; i++) {
+    _events[i].output = NULL;
+  }
+  _max_lateness = 0;
+}
+
+// SETUP -----------------------------------------------------------------------
+void Valve_scheduler::begin() {
+  active_scheduler = this;
+#ifdef __AVR__
+  noInterrupts();
+  // TIMER 3, NORMAL MODE, PRESCALER 64, COMPARE MATCH A INTERRUPT:
+  TCCR3A = 0;
+  TCCR3B = _BV(CS31) | _BV(CS30);
+  TCNT3 = 0;
+  set_next_compare(micros());
+  TIFR3 = _BV(OCF3A);
+  TIMSK3 = _BV(OCIE3A);
+  interrupts();
+#else
+  native_attach_timer_interrupt(switch_due_valves_of_active_scheduler, NATIVE_VALVE_TIMER_PERIOD);
+#endif
+}
+
+// SCHEDULE --------------------------------------------------------------------
+bool Valve_scheduler::schedule(Image_output &output, bool state, unsigned long delay) {
+  bool is_scheduled = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    unsigned long now = micros();
+    for (byte i = 0; i < VALVE_SCHEDULER_MAX_EVENTS; i++) {
+      if (_events[i].output == NULL) {
+        _events[i].output = &output;
+        _events[i].time = now + delay;
+        _events[i].state = state;
+        is_scheduled = true;
+        break;
+      }
+    }
+    set_next_compare(now);
+  }
+  return is_scheduled;
+}
+
+bool Valve_scheduler::is_pending(Image_output &output) {
+  bool is_pending = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (byte i = 0; i < VALVE_SCHEDULER_MAX_EVENTS; i++) {
+      if (_events[i].output == &output) {
+        is_pending = true;
+      }
+    }
+  }
+  return is_pending;
+}
+
+void Valve_scheduler::cancel_all() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (byte i = 0; i < VALVE_SCHEDULER_MAX_EVENTS; i++) {
+      _events[i].output = NULL;
+    }
+  }
+}
+
+unsigned long Valve_scheduler::get_max_lateness() {
+  unsigned long max_lateness;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { max_lateness = _max_lateness; }
+  return max_lateness;
+}
+
+// SWITCH (ISR) ----------------------------------------------------------------
+void Valve_scheduler::switch_due_valves() {
+  unsigned long now = micros();
+  for (byte i = 0; i < VALVE_SCHEDULER_MAX_EVENTS; i++) {
+    Valve_event &event = _events[i];
+    if (event.output == NULL || (long)(now - event.time) < 0) {
+      continue;
+    }
+    event.output->set_now(event.state);
+    event.output = NULL;
+    if (now - event.time > _max_lateness) {
+      _max_lateness = now - event.time;
+    }
+  }
+  set_next_compare(now);
+}
+
+// Interrupts must be disabled:
+void Valve_scheduler::set_next_compare(unsigned long now) {
+#ifdef __AVR__
+  unsigned long step = MAX_COMPARE_STEP;
+  for (byte i = 0; i < VALVE_SCHEDULER_MAX_EVENTS; i++) {
+    if (_events[i].output == NULL) {
+      continue;
+    }
+    long time_left = _events[i].time - now;
+    unsigned long event_step = time_left > 0 ? time_left / MICROS_PER_TICK : 0;
+    if (event_step < step) {
+      step = event_step;
+    }
+  }
+  if (step < MIN_COMPARE_STEP) {
+    step = MIN_COMPARE_STEP;
+  }
+  OCR3A = TCNT3 + step;
+#else
+  (void)now; // the host timer polls at a fixed period
+#endif
+}
+
+#ifdef __AVR__
+ISR(TIMER3_COMPA_vect) {
+  if (active_scheduler) {
+    active_scheduler->switch_due_valves();
+  }
+}
+#else
+static void switch_due_valves_of_active_scheduler() {
+  if (active_scheduler) {
+    active_scheduler->switch_due_valves();
+  }
+}
+#endif
+
+// STROKE ----------------------------------------------------------------------
+Valve_stroke::Valve_stroke(Valve_scheduler &scheduler, Image_output &output)
+    : _scheduler(scheduler), _output(output) {
+  _start_time = 0;
+  _duration = 0;
+  _is_running = false;
+}
+
+// The valve is only switched on if its release could be scheduled, it must
+// never stay on. Returns false if the scheduler is full:
+bool Valve_stroke::start(unsigned long push_time, unsigned long release_time) {
+  bool is_scheduled;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    is_scheduled = _scheduler.schedule(_output, 0, push_time * 1000);
+    _output.set_now(is_scheduled);
+  }
+  _start_time = micros();
+  _duration = (push_time + release_time) * 1000;
+  _is_running = is_scheduled;
+  return is_scheduled;
+}
+
+bool Valve_stroke::is_completed() {
+  if (!_is_running || _scheduler.is_pending(_output)) {
+    return false;
+  }
+  if (micros() - _start_time < _duration) {
+    return false;
+  }
+  _is_running = false;
+  return true;
+}
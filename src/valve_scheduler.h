@@ -0,0 +1,88 @@
+/* *****************************************************************************
+ * valve_scheduler.h ***********************************************************
+ * *****************************************************************************
+ * TIMER DRIVEN SWITCHING OF CYLINDER VALVES (ATMEGA2560)
+ *
+ * Valve events (output, state, time) are switched in the compare interrupt
+ * of timer 3 at their due time, independent of the main loop. The timer runs
+ * free with 4us per tick, the compare register is always set to the next due
+ * event (or 200ms ahead at most, if the next event is further away).
+ *
+ * Valve_stroke switches a valve on at
+ * start(), the interrupt switches it off after the push time, and the stroke
+ * is completed after the release time. The step only checks completion.
+ * If the scheduler is full, the valve is not switched on and start() returns
+ * false.
+ *
+ * The interrupt writes the output pin immediately (Image_output::set_now()),
+ * not at the end of the scan. The loop must not switch an output that has a
+ * pending event, except after cancel_all(). Uses Timer 3 exclusively.
+ * *****************************************************************************
+ */
+
+#ifndef ValveScheduler_H_
+#define ValveScheduler_H_
+
+#include <Arduino.h>
+#include <process_image.h>
+
+#ifndef VALVE_SCHEDULER_MAX_EVENTS
+#define VALVE_SCHEDULER_MAX_EVENTS 8
+#endif
+
+class Valve_scheduler {
+
+public:
+  // FUNCTIONS:
+  Valve_scheduler();
+
+  void begin();
+
+  bool schedule(Image_output &output, bool state, unsigned long delay); // [us], false if full
+  bool is_pending(Image_output &output);
+  void cancel_all();
+
+  unsigned long get_max_lateness(); // [us] from due time to switching
+
+  // Called by the compare interrupt:
+  void switch_due_valves();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void set_next_compare(unsigned long now);
+
+  // VARIABLES:
+  struct Valve_event {
+    Image_output *output; // NULL = free slot
+    unsigned long time; // [us]
+    bool state;
+  };
+
+  Valve_event _events[VALVE_SCHEDULER_MAX_EVENTS];
+  volatile unsigned long _max_lateness;
+};
+
+class Valve_stroke {
+
+public:
+  // FUNCTIONS:
+  Valve_stroke(Valve_scheduler &scheduler, Image_output &output);
+
+  bool start(unsigned long push_time, unsigned long release_time); // [ms], false if not started
+  bool is_completed(); // one time flag
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // VARIABLES:
+  Valve_scheduler &_scheduler;
+  Image_output &_output;
+  unsigned long _start_time; // [us]
+  unsigned long _duration; // [us]
+  bool _is_running;
+};
+#endif /* ValveScheduler_H_ */
@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * vent_detector.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "vent_detector.h"
+#include "pressure_sampler.h"
+
+// 1bar => analogRead 27.778 (see pressure_filter.cpp), per mbar and block sum:
+const unsigned long ADC_PER_KILO_BAR = 27778;
+const unsigned long BLOCK_CONVERSIONS = (unsigned long)VENT_DETECTOR_BLOCK_SAMPLES * PRESSURE_OVERSAMPLING;
+const unsigned long WINDOW_SAMPLES = (unsigned long)VENT_DETECTOR_WINDOW * VENT_DETECTOR_BLOCK_SAMPLES;
+
+static unsigned long mbar_to_block_sum(int pressure) {
+  return pressure * BLOCK_CONVERSIONS * ADC_PER_KILO_BAR / 1000000;
+}
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Vent_detector::Vent_detector() {
+  _is_active = false;
+  _log_head = 0;
+  _log_count = 0;
+}
+
+// VENT ------------------------------------------------------------------------
+void Vent_detector::start(byte step, int residual_pressure, byte confidence) {
+  _is_active = true;
+  _step = step;
+  _residual_sum = mbar_to_block_sum(residual_pressure);
+  _min_fit_sum = mbar_to_block_sum(VENT_DETECTOR_MIN_FIT_PRESSURE);
+  _confidence = max(confidence, (byte)1);
+  _sample_count = 0;
+  _block_sum = 0;
+  _block_samples = 0;
+  _block_count = 0;
+  _window_head = 0;
+  _consistent_count = 0;
+  _fitted_windows = 0;
+  _prediction_ratio = 0;
+  _predicted_end = 0;
+  _is_below_residual = false;
+}
+
+void Vent_detector::add_sample(unsigned int adc_sum) {
+  if (!_is_active) {
+    return;
+  }
+  _sample_count++;
+  _block_sum += adc_sum;
+  _block_samples++;
+  if (_block_samples >= VENT_DETECTOR_BLOCK_SAMPLES) {
+    add_block(_block_sum);
+    _block_sum = 0;
+    _block_samples = 0;
+  }
+}
+
+void Vent_detector::add_block(unsigned long block_sum) {
+  if (block_sum < _residual_sum) {
+    _is_below_residual = true;
+  }
+  unsigned long window_start_sum = _window[_window_head];
+  _window[_window_head] = block_sum;
+  _window_head = (_window_head + 1) % VENT_DETECTOR_WINDOW;
+  if (_block_count < VENT_DETECTOR_WINDOW) {
+    _block_count++;
+    return;
+  }
+  if (window_start_sum < _min_fit_sum) {
+    return; // too little signal, keep the prediction made so far
+  }
+  if (block_sum >= window_start_sum) {
+    _consistent_count = 0; // not decaying
+    _predicted_end = 0;
+    return;
+  }
+
+  unsigned int ratio = (block_sum << 16) / window_start_sum;
+  if (_consistent_count > 0 && abs((long)ratio - (long)_previous_ratio) <= VENT_DETECTOR_RATIO_TOLERANCE) {
+    _consistent_count = min(_consistent_count + 1, 255);
+    _slowest_ratio = max(_slowest_ratio, ratio);
+  } else {
+    _consistent_count = 1;
+    _slowest_ratio = ratio;
+  }
+  _previous_ratio = ratio;
+
+  if (_consistent_count >= _confidence) {
+    predict(block_sum);
+  }
+}
+
+// Extrapolates the decay by windows until the block sum is below the residual
+// pressure, within the last window linear (the chord lies above the decay):
+void Vent_detector::predict(unsigned long block_sum) {
+  unsigned long previous_sum = block_sum;
+  byte windows = 0;
+  while (block_sum >= _residual_sum && windows < VENT_DETECTOR_MAX_PREDICTED_WINDOWS) {
+    previous_sum = block_sum;
+    block_sum = (block_sum * _slowest_ratio) >> 16;
+    windows++;
+  }
+  if (block_sum >= _residual_sum) {
+    _predicted_end = 0; // too slow to predict
+    return;
+  }
+  _predicted_end = _sample_count;
+  if (windows > 0) {
+    unsigned long drop = previous_sum - block_sum;
+    _predicted_end += (windows - 1) * WINDOW_SAMPLES;
+    _predicted_end += (WINDOW_SAMPLES * (previous_sum - _residual_sum) + drop - 1) / drop;
+  }
+  _prediction_ratio = _slowest_ratio;
+  _fitted_windows = _consistent_count;
+}
+
+bool Vent_detector::is_vented() {
+  if (!_is_active) {
+    return false;
+  }
+  return _is_below_residual || (_predicted_end && _sample_count >= _predicted_end);
+}
+
+// LOG -------------------------------------------------------------------------
+void Vent_detector::finish(bool is_vented_by_detector) {
+  if (!_is_active) {
+    return;
+  }
+  _is_active = false;
+
+  Vent_decision &entry = _log[_log_head];
+  entry.step = _step;
+  if (!is_vented_by_detector) {
+    entry.kind = vent_threshold;
+  } else if (_predicted_end && _sample_count >= _predicted_end) {
+    entry.kind = vent_predicted;
+  } else {
+    entry.kind = vent_measured;
+  }
+  entry.vent_time = samples_to_ms(_sample_count);
+  entry.predicted_time = samples_to_ms(_predicted_end);
+  entry.decay_ratio = _predicted_end ? _prediction_ratio : 0;
+  entry.fitted_windows = _predicted_end ? _fitted_windows : 0;
+  _log_head = (_log_head + 1) % VENT_LOG_SIZE;
+  if (_log_count < VENT_LOG_SIZE) {
+    _log_count++;
+  }
+}
+
+unsigned int Vent_detector::samples_to_ms(unsigned long samples) {
+  return min(samples * 1000 / PRESSURE_SAMPLE_RATE, 0xFFFFUL);
+}
+
+byte Vent_detector::get_number_of_logged_decisions() { return _log_count; }
+
+Vent_decision Vent_detector::get_logged_decision(byte age) {
+  return _log[(_log_head + VENT_LOG_SIZE - 1 - age) % VENT_LOG_SIZE];
+}
@@ -0,0 +1,111 @@
+/* *****************************************************************************
+ * vent_detector.h *************************************************************
+ * *****************************************************************************
+ * PREDICTS THE END OF VENTING FROM THE PRESSURE DECAY
+ *
+ * While the 800mm cylinder vents, the pressure decays exponentially. The raw
+ * samples of the pressure sampler are summed up in blocks of
+ * VENT_DETECTOR_BLOCK_SAMPLES. The ratio of a block sum to the block sum
+ * VENT_DETECTOR_WINDOW blocks earlier is the decay per window. As soon as
+ * "confidence" ratios in a row agree within VENT_DETECTOR_RATIO_TOLERANCE, the
+ * decay is extrapolated with the slowest of these ratios to the time the
+ * pressure falls below the residual pressure. The prediction is updated with
+ * every block while the pressure is above VENT_DETECTOR_MIN_FIT_PRESSURE,
+ * where the sensor has enough resolution. A block below the residual pressure
+ * ends the vent without a prediction (e.g. the cylinder was already vented).
+ *
+ * Times are counted in samples (sample clock of the pressure sampler). The
+ * decision of every vent is logged (VENT_LOG_SIZE entries), also if the step
+ * has ended by its pressure threshold first.
+ *
+ * The parameters are defined in main.cpp.
+ * *****************************************************************************
+ */
+
+#ifndef VentDetector_H_
+#define VentDetector_H_
+
+#include <Arduino.h>
+
+#define VENT_DETECTOR_BLOCK_SAMPLES 16
+#define VENT_DETECTOR_WINDOW 8 // [blocks]
+#define VENT_DETECTOR_RATIO_TOLERANCE 3277 // [Q16] 5%
+#define VENT_DETECTOR_MIN_FIT_PRESSURE 150 // [mbar]
+#define VENT_DETECTOR_MAX_PREDICTED_WINDOWS 32
+
+#ifndef VENT_LOG_SIZE
+#define VENT_LOG_SIZE 8
+#endif
+
+struct Vent_parameters {
+  bool is_predictive; // false: the steps only wait for the pressure threshold
+  int residual_pressure; // [mbar] negligible pressure
+  byte confidence; // consistent decay ratios in a row needed for a prediction
+};
+
+extern Vent_parameters vent_parameters;
+
+enum vent_decision_kind {
+  vent_predicted, // extrapolated decay has crossed the residual pressure
+  vent_measured, // a block was below the residual pressure
+  vent_threshold // ended by the pressure threshold of the step
+};
+
+struct Vent_decision {
+  byte step;
+  byte kind; // vent_decision_kind
+  unsigned int vent_time; // [ms] until the decision
+  unsigned int predicted_time; // [ms] 0 = no prediction
+  unsigned int decay_ratio; // [Q16] per window
+  byte fitted_windows; // ratios in a row the prediction is based on
+};
+
+class Vent_detector {
+
+public:
+  // FUNCTIONS:
+  Vent_detector();
+
+  void start(byte step, int residual_pressure, byte confidence); // [mbar]
+  void add_sample(unsigned int adc_sum); // oversampled sample of the sampler
+  bool is_vented(); // prediction or measurement has crossed the residual pressure
+  void finish(bool is_vented_by_detector); // false: ended by the step
+
+  byte get_number_of_logged_decisions();
+  Vent_decision get_logged_decision(byte age); // 0 = latest
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // FUNCTIONS:
+  void add_block(unsigned long block_sum);
+  void predict(unsigned long block_sum);
+  unsigned int samples_to_ms(unsigned long samples);
+
+  // VARIABLES:
+  bool _is_active;
+  byte _step;
+  unsigned long _residual_sum; // residual pressure as block sum
+  unsigned long _min_fit_sum;
+  byte _confidence;
+
+  unsigned long _sample_count; // since start
+  unsigned long _block_sum;
+  byte _block_samples;
+  unsigned long _window[VENT_DETECTOR_WINDOW]; // block sums, ring buffer
+  byte _block_count; // since start, up to VENT_DETECTOR_WINDOW
+  byte _window_head; // oldest block sum
+  unsigned int _previous_ratio;
+  unsigned int _slowest_ratio;
+  byte _consistent_count;
+  byte _fitted_windows;
+  unsigned int _prediction_ratio;
+  unsigned long _predicted_end; // [samples] 0 = no prediction
+  bool _is_below_residual;
+
+  Vent_decision _log[VENT_LOG_SIZE];
+  byte _log_head; // next entry
+  byte _log_count;
+};
+#endif /* VentDetector_H_ */
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * weld_detector.cpp ***********************************************************
+ *******************************************************************************/
+
+#include "weld_detector.h"
+
+// CONSTRUCTOR -----------------------------------------------------------------
+Weld_detector::Weld_detector() {
+  _is_active = false;
+  reset_statistics();
+}
+
+// WELD ------------------------------------------------------------------------
+void Weld_detector::start() {
+  _is_active = true;
+  _start_time = millis();
+}
+
+bool Weld_detector::is_completed(bool is_tool_ready) {
+  if (!_is_active || !weld_parameters.is_early_release || !weld_parameters.uses_ready_input) {
+    return false; // without the ready input nothing tells the end of the weld
+  }
+  if (millis() - _start_time < weld_parameters.minimum_time) {
+    return false;
+  }
+  return is_tool_ready;
+}
+
+// STATISTICS ------------------------------------------------------------------
+void Weld_detector::finish(bool is_released_early, unsigned long ceiling) {
+  if (!_is_active) {
+    return;
+  }
+  _is_active = false;
+
+  _weld_count++;
+  _last_weld_time = min(millis() - _start_time, 0xFFFFUL);
+  _last_time_saved = 0;
+  if (is_released_early) {
+    _early_release_count++;
+    if (ceiling > _last_weld_time) {
+      _last_time_saved = ceiling - _last_weld_time;
+    }
+  }
+  _total_time_saved += _last_time_saved;
+}
+
+unsigned long Weld_detector::get_weld_count() { return _weld_count; }
+
+unsigned long Weld_detector::get_early_release_count() { return _early_release_count; }
+
+unsigned int Weld_detector::get_last_weld_time() { return _last_weld_time; }
+
+unsigned int Weld_detector::get_last_time_saved() { return _last_time_saved; }
+
+unsigned int Weld_detector::get_mean_time_saved() {
+  if (_weld_count == 0) {
+    return 0;
+  }
+  return _total_time_saved / _weld_count;
+}
+
+unsigned long Weld_detector::get_total_time_saved() { return _total_time_saved / 1000; }
+
+void Weld_detector::reset_statistics() {
+  _weld_count = 0;
+  _early_release_count = 0;
+  _last_weld_time = 0;
+  _last_time_saved = 0;
+  _total_time_saved = 0;
+}
@@ -0,0 +1,69 @@
+/* *****************************************************************************
+ * weld_detector.h *************************************************************
+ * *****************************************************************************
+ * RELEASES THE WELD STEP WHEN THE TOOL REPORTS READY
+ *
+ * The step "Schweissen" pushes the weld button of the tool and vents the
+ * 800mm cylinder. The pressure sensor only sees the cylinder, not the weld,
+ * so the end of the weld is taken from the ready output of the tool
+ * (werkzeug_bereit). The step may release before its fixed stroke when:
+ * - early release is enabled and the tool has a ready input (early release
+ *   without the ready input is refused), and
+ * - the minimum weld time has passed (a ready signal still active from the
+ *   last weld is ignored), and
+ * - the tool ready input is active.
+ * The fixed stroke stays the hard ceiling. Early release is off by default.
+ *
+ * Every weld is counted in the statistics, with the time saved against the
+ * ceiling when the tool has reported ready.
+ *
+ * The parameters are defined in main.cpp.
+ * *****************************************************************************
+ */
+
+#ifndef WeldDetector_H_
+#define WeldDetector_H_
+
+#include <Arduino.h>
+
+struct Weld_parameters {
+  bool is_early_release; // false: the step waits for the stroke (ceiling)
+  unsigned int minimum_time; // [ms] from the weld start, the ready input is ignored before
+  bool uses_ready_input; // the tool has a ready output, needed for early release
+};
+
+extern Weld_parameters weld_parameters;
+
+class Weld_detector {
+
+public:
+  // FUNCTIONS:
+  Weld_detector();
+
+  void start();
+  bool is_completed(bool is_tool_ready);
+  void finish(bool is_released_early, unsigned long ceiling); // [ms] duration of the stroke
+
+  unsigned long get_weld_count();
+  unsigned long get_early_release_count();
+  unsigned int get_last_weld_time(); // [ms]
+  unsigned int get_last_time_saved(); // [ms]
+  unsigned int get_mean_time_saved(); // [ms] per weld
+  unsigned long get_total_time_saved(); // [s]
+  void reset_statistics();
+
+  // VARIABLES:
+  // n.a.
+
+private:
+  // VARIABLES:
+  bool _is_active;
+  unsigned long _start_time; // [ms]
+
+  unsigned long _weld_count;
+  unsigned long _early_release_count;
+  unsigned int _last_weld_time;
+  unsigned int _last_time_saved;
+  unsigned long _total_time_saved; // [ms]
+};
+#endif /* WeldDetector_H_ */
@@ -0,0 +1,221 @@
+/*******************************************************************************
+ * test_nextion_touch.cpp ******************************************************
+ *******************************************************************************
+ * Nextion_touch_parser on the host, run with: pio test -e native_test
+ *
+ * Checks the dispatch of touch frames and compares the latency with nexLoop()
+ * of the ITEAD library, which is reproduced below (the library itself has no
+ * host port). Time is measured with the virtual clock of the native HAL.
+ *******************************************************************************/
+
+#include <chrono> // before Arduino.h, which defines min() and max()
+#include <stdio.h>
+#include <unity.h>
+
+#include <native_hal.h>
+#include <nextion_touch.h>
+
+// COMPONENTS OF THE FIRMWARE (page, id) ---------------------------------------
+const Nextion_component components[] = {
+    // PAGE 0:
+    {0, 0},
+    // PAGE 1:
+    {1, 0}, {1, 6}, {1, 7}, {1, 5}, {1, 22}, {1, 4}, {1, 17}, {1, 16}, {1, 11}, {1, 13}, {1, 12}, {1, 10}, {1, 9},
+    {1, 8}, {1, 15},
+    // PAGE 2:
+    {2, 0}, {2, 5}, {2, 6}, {2, 8}, {2, 10}, {2, 12}, {2, 14}, {2, 16}, {2, 18},
+    // PAGE 3:
+    {3, 0}, {3, 6}};
+const byte NUMBER_OF_COMPONENTS = sizeof(components) / sizeof(Nextion_component);
+
+unsigned int push_count;
+unsigned int pop_count;
+unsigned long long callback_time; // [us]
+
+void push_callback(void *ptr) {
+  push_count++;
+  callback_time = native_get_micros();
+}
+
+void pop_callback(void *ptr) {
+  pop_count++;
+  callback_time = native_get_micros();
+}
+
+void inject_frame(Nextion_component component, byte event) {
+  const uint8_t frame[] = {0x65, component.page, component.id, event, 0xFF, 0xFF, 0xFF};
+  Serial2.inject(frame, sizeof(frame));
+}
+
+void attach_all(Nextion_touch_parser &parser) {
+  for (byte i = 0; i < NUMBER_OF_COMPONENTS; i++) {
+    parser.attach_push(components[i], push_callback);
+    parser.attach_pop(components[i], pop_callback);
+  }
+}
+
+// REFERENCE: nexLoop() OF THE ITEAD LIBRARY -----------------------------------
+// Same logic as nexLoop() (NexHardware.cpp) and NexTouch::iterate(): a delay
+// of 10 ms for every byte read and a linear search of the listen list.
+void reference_nex_loop() {
+  static uint8_t buffer[10];
+  while (Serial2.available() > 0) {
+    delay(10);
+    uint8_t c = Serial2.read();
+    if (c == 0x65 && Serial2.available() >= 6) {
+      buffer[0] = c;
+      for (byte i = 1; i < 7; i++) {
+        buffer[i] = Serial2.read();
+      }
+      if (buffer[4] == 0xFF && buffer[5] == 0xFF && buffer[6] == 0xFF) {
+        for (byte i = 0; i < NUMBER_OF_COMPONENTS; i++) {
+          if (components[i].page == buffer[1] && components[i].id == buffer[2]) {
+            if (buffer[3] == 0x01) {
+              push_callback(NULL);
+            } else if (buffer[3] == 0x00) {
+              pop_callback(NULL);
+            }
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+// SETUP -----------------------------------------------------------------------
+void setUp() {
+  native_use_virtual_clock(true);
+  while (Serial2.available() > 0) {
+    Serial2.read();
+  }
+  push_count = 0;
+  pop_count = 0;
+}
+
+void tearDown() {}
+
+// DISPATCH --------------------------------------------------------------------
+void test_every_component_is_dispatched() {
+  Nextion_touch_parser parser(Serial2);
+  attach_all(parser);
+  for (byte i = 0; i < NUMBER_OF_COMPONENTS; i++) {
+    inject_frame(components[i], 0x01);
+    inject_frame(components[i], 0x00);
+  }
+  parser.read_events();
+  TEST_ASSERT_EQUAL(NUMBER_OF_COMPONENTS, push_count);
+  TEST_ASSERT_EQUAL(NUMBER_OF_COMPONENTS, pop_count);
+  TEST_ASSERT_EQUAL(2 * NUMBER_OF_COMPONENTS, parser.get_event_count());
+  TEST_ASSERT_EQUAL(0, parser.get_frame_error_count());
+}
+
+void test_frame_split_over_several_calls() {
+  Nextion_touch_parser parser(Serial2);
+  attach_all(parser);
+  const uint8_t frame[] = {0x65, 1, 22, 0x01, 0xFF, 0xFF, 0xFF};
+  for (byte i = 0; i < sizeof(frame); i++) {
+    TEST_ASSERT_EQUAL(0, push_count);
+    Serial2.inject(&frame[i], 1);
+    parser.read_events();
+  }
+  TEST_ASSERT_EQUAL(1, push_count);
+}
+
+void test_other_frames_are_skipped() {
+  Nextion_touch_parser parser(Serial2);
+  attach_all(parser);
+  const uint8_t page_frame[] = {0x66, 0x01, 0xFF, 0xFF, 0xFF}; // current page
+  const uint8_t error_frame[] = {0x1A, 0xFF, 0xFF, 0xFF}; // invalid variable
+  const uint8_t broken_frame[] = {0x65, 1, 22, 0x01, 0xFF, 0x00, 0xFF, 0xFF, 0xFF};
+  Serial2.inject(page_frame, sizeof(page_frame));
+  inject_frame({1, 5}, 0x01);
+  Serial2.inject(error_frame, sizeof(error_frame));
+  Serial2.inject(broken_frame, sizeof(broken_frame));
+  inject_frame({1, 6}, 0x01);
+  inject_frame({4, 9}, 0x01); // no callback registered
+  parser.read_events();
+  TEST_ASSERT_EQUAL(2, push_count);
+  TEST_ASSERT_EQUAL(1, parser.get_frame_error_count());
+}
+
+// BENCHMARK AGAINST nexLoop() -------------------------------------------------
+// One touch frame is received between two scans of the main loop. Latency is
+// the time until the callback runs, blocked the time the scan is held up.
+void test_latency_against_nex_loop() {
+  const unsigned int NUMBER_OF_FRAMES = 1000;
+  Nextion_touch_parser parser(Serial2);
+  attach_all(parser);
+
+  unsigned long long parser_latency = 0;
+  unsigned long long parser_blocked = 0;
+  unsigned long long reference_latency = 0;
+  unsigned long long reference_blocked = 0;
+  std::chrono::nanoseconds parser_cpu_time(0);
+  std::chrono::nanoseconds reference_cpu_time(0);
+
+  for (unsigned int i = 0; i < NUMBER_OF_FRAMES; i++) {
+    // Last entry of the listen list, worst case of the linear search:
+    inject_frame(components[NUMBER_OF_COMPONENTS - 1], 0x01);
+    unsigned long long start_time = native_get_micros();
+    auto cpu_start_time = std::chrono::steady_clock::now();
+    parser.read_events();
+    parser_cpu_time += std::chrono::steady_clock::now() - cpu_start_time;
+    parser_latency += callback_time - start_time;
+    parser_blocked += native_get_micros() - start_time;
+
+    inject_frame(components[NUMBER_OF_COMPONENTS - 1], 0x01);
+    start_time = native_get_micros();
+    cpu_start_time = std::chrono::steady_clock::now();
+    reference_nex_loop();
+    reference_cpu_time += std::chrono::steady_clock::now() - cpu_start_time;
+    reference_latency += callback_time - start_time;
+    reference_blocked += native_get_micros() - start_time;
+  }
+  TEST_ASSERT_EQUAL(2 * NUMBER_OF_FRAMES, push_count);
+
+  char report[160];
+  snprintf(report, sizeof(report), "parser:    latency %llu us, loop blocked %llu us, host cpu %lld ns per frame",
+           parser_latency / NUMBER_OF_FRAMES, parser_blocked / NUMBER_OF_FRAMES,
+           (long long)(parser_cpu_time.count() / NUMBER_OF_FRAMES));
+  TEST_MESSAGE(report);
+  snprintf(report, sizeof(report), "nexLoop(): latency %llu us, loop blocked %llu us, host cpu %lld ns per frame",
+           reference_latency / NUMBER_OF_FRAMES, reference_blocked / NUMBER_OF_FRAMES,
+           (long long)(reference_cpu_time.count() / NUMBER_OF_FRAMES));
+  TEST_MESSAGE(report);
+
+  // The parser never waits, nexLoop() waits 10 ms for every frame:
+  TEST_ASSERT_EQUAL(0, parser_blocked);
+  TEST_ASSERT_EQUAL(0, parser_latency);
+  TEST_ASSERT_EQUAL(10000ULL * NUMBER_OF_FRAMES, reference_latency);
+}
+
+// A frame that is not completely received when nexLoop() runs is lost:
+void test_split_frame_against_nex_loop() {
+  Nextion_touch_parser parser(Serial2);
+  attach_all(parser);
+  const uint8_t first_part[] = {0x65, 1, 22};
+  const uint8_t second_part[] = {0x01, 0xFF, 0xFF, 0xFF};
+
+  Serial2.inject(first_part, sizeof(first_part));
+  parser.read_events();
+  Serial2.inject(second_part, sizeof(second_part));
+  parser.read_events();
+  TEST_ASSERT_EQUAL(1, push_count);
+
+  Serial2.inject(first_part, sizeof(first_part));
+  reference_nex_loop();
+  Serial2.inject(second_part, sizeof(second_part));
+  reference_nex_loop();
+  TEST_ASSERT_EQUAL(1, push_count);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_component_is_dispatched);
+  RUN_TEST(test_frame_split_over_several_calls);
+  RUN_TEST(test_other_frames_are_skipped);
+  RUN_TEST(test_latency_against_nex_loop);
+  RUN_TEST(test_split_frame_against_nex_loop);
+  return UNITY_END();
+}
@@ -0,0 +1,272 @@
+/*******************************************************************************
+ * test_state_controller.cpp ***************************************************
+ *******************************************************************************
+ * State_controller on the host, run with: pio test -e native_test
+ *
+ * Every mode/event pair (and every sequence of three events) is compared with
+ * the former implementation of four exclusive mode bools, reproduced below.
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <unity.h>
+
+#include <native_hal.h>
+#include <state_controller.h>
+
+// REFERENCE: FORMER MODE BOOLS ------------------------------------------------
+class Bool_state_controller {
+public:
+  void set_step_mode() { set_modes(true, false, false, false); }
+  void set_auto_mode() { set_modes(false, true, false, false); }
+  void set_error_mode() { set_modes(false, false, true, false); }
+  void set_reset_mode() { set_modes(false, false, false, true); }
+  void toggle_step_auto_mode() {
+    if (_auto_mode) {
+      set_step_mode();
+    } else {
+      set_auto_mode();
+    }
+  }
+
+  bool _step_mode = false;
+  bool _auto_mode = false;
+  bool _error_mode = false;
+  bool _reset_mode = false;
+
+private:
+  void set_modes(bool step, bool automatic, bool error, bool reset) {
+    _step_mode = step;
+    _auto_mode = automatic;
+    _error_mode = error;
+    _reset_mode = reset;
+  }
+};
+
+// EVENTS ----------------------------------------------------------------------
+// Through the public interface, as main.cpp uses it:
+void send_event(State_controller &controller, byte event) {
+  switch (event) {
+  case event_set_step_mode:
+    controller.set_step_mode();
+    break;
+  case event_set_auto_mode:
+    controller.set_auto_mode();
+    break;
+  case event_set_error_mode:
+    controller.set_error_mode();
+    break;
+  case event_set_reset_mode:
+    controller.set_reset_mode();
+    break;
+  case event_toggle_step_auto_mode:
+    controller.toggle_step_auto_mode();
+    break;
+  }
+}
+
+void send_event(Bool_state_controller &controller, byte event) {
+  switch (event) {
+  case event_set_step_mode:
+    controller.set_step_mode();
+    break;
+  case event_set_auto_mode:
+    controller.set_auto_mode();
+    break;
+  case event_set_error_mode:
+    controller.set_error_mode();
+    break;
+  case event_set_reset_mode:
+    controller.set_reset_mode();
+    break;
+  case event_toggle_step_auto_mode:
+    controller.toggle_step_auto_mode();
+    break;
+  }
+}
+
+// The event that brings both controllers into a mode:
+byte get_event_to_enter(byte mode) {
+  switch (mode) {
+  case auto_mode:
+    return event_set_auto_mode;
+  case error_mode:
+    return event_set_error_mode;
+  case reset_mode:
+    return event_set_reset_mode;
+  default:
+    return event_set_step_mode;
+  }
+}
+
+void assert_same_mode(State_controller &controller, Bool_state_controller &reference, const char *case_name) {
+  TEST_ASSERT_EQUAL_MESSAGE(reference._step_mode, controller.is_in_step_mode(), case_name);
+  TEST_ASSERT_EQUAL_MESSAGE(reference._auto_mode, controller.is_in_auto_mode(), case_name);
+  TEST_ASSERT_EQUAL_MESSAGE(reference._error_mode, controller.is_in_error_mode(), case_name);
+  TEST_ASSERT_EQUAL_MESSAGE(reference._reset_mode, controller.is_in_reset_mode(), case_name);
+  // Exactly one mode:
+  byte number_of_modes = controller.is_in_step_mode() + controller.is_in_auto_mode() + controller.is_in_error_mode() +
+                         controller.is_in_reset_mode();
+  TEST_ASSERT_EQUAL_MESSAGE(1, number_of_modes, case_name);
+}
+
+// SETUP -----------------------------------------------------------------------
+void setUp() {
+  native_use_virtual_clock(true);
+  native_set_micros(0);
+}
+
+void tearDown() {}
+
+// TRANSITIONS -----------------------------------------------------------------
+void test_initial_mode() {
+  State_controller controller(14);
+  TEST_ASSERT_TRUE(controller.is_in_step_mode());
+  TEST_ASSERT_FALSE(controller.machine_is_running());
+  TEST_ASSERT_EQUAL(0, controller.get_current_step());
+  TEST_ASSERT_EQUAL(0, controller.get_number_of_logged_transitions());
+}
+
+void test_every_mode_and_event() {
+  char case_name[40];
+  for (byte mode = 0; mode < end_of_mode_enum; mode++) {
+    for (byte event = 0; event < end_of_mode_event_enum; event++) {
+      snprintf(case_name, sizeof(case_name), "mode %d event %d", mode, event);
+      State_controller controller;
+      Bool_state_controller reference;
+      send_event(controller, get_event_to_enter(mode));
+      send_event(reference, get_event_to_enter(mode));
+      TEST_ASSERT_EQUAL_MESSAGE(mode, controller.get_mode(), case_name);
+
+      send_event(controller, event);
+      send_event(reference, event);
+      assert_same_mode(controller, reference, case_name);
+    }
+  }
+}
+
+void test_every_sequence_of_three_events() {
+  char case_name[40];
+  for (byte first = 0; first < end_of_mode_event_enum; first++) {
+    for (byte second = 0; second < end_of_mode_event_enum; second++) {
+      for (byte third = 0; third < end_of_mode_event_enum; third++) {
+        snprintf(case_name, sizeof(case_name), "events %d %d %d", first, second, third);
+        State_controller controller;
+        Bool_state_controller reference;
+        reference.set_step_mode(); // initial mode of State_controller
+        const byte events[] = {first, second, third};
+        for (byte i = 0; i < 3; i++) {
+          send_event(controller, events[i]);
+          send_event(reference, events[i]);
+          assert_same_mode(controller, reference, case_name);
+        }
+      }
+    }
+  }
+}
+
+void test_handle_event_equals_setters() {
+  for (byte mode = 0; mode < end_of_mode_enum; mode++) {
+    for (byte event = 0; event < end_of_mode_event_enum; event++) {
+      State_controller by_setter;
+      State_controller by_event;
+      send_event(by_setter, get_event_to_enter(mode));
+      by_event.handle_event(get_event_to_enter(mode));
+      send_event(by_setter, event);
+      by_event.handle_event(event);
+      TEST_ASSERT_EQUAL(by_setter.get_mode(), by_event.get_mode());
+    }
+  }
+}
+
+void test_invalid_event_is_ignored() {
+  State_controller controller;
+  controller.set_auto_mode();
+  controller.handle_event(end_of_mode_event_enum);
+  controller.handle_event(255);
+  TEST_ASSERT_TRUE(controller.is_in_auto_mode());
+  TEST_ASSERT_EQUAL(1, controller.get_number_of_logged_transitions());
+}
+
+// The running state does not depend on the mode:
+void test_machine_running_is_independent() {
+  for (byte event = 0; event < end_of_mode_event_enum; event++) {
+    State_controller controller;
+    controller.set_machine_running();
+    controller.set_run_after_reset(true);
+    controller.handle_event(event);
+    TEST_ASSERT_TRUE(controller.machine_is_running());
+    TEST_ASSERT_TRUE(controller.run_after_reset_is_active());
+  }
+  State_controller controller;
+  controller.toggle_machine_running_state();
+  TEST_ASSERT_TRUE(controller.machine_is_running());
+  controller.set_machine_stop();
+  TEST_ASSERT_FALSE(controller.machine_is_running());
+}
+
+// LOG -------------------------------------------------------------------------
+void test_transition_log() {
+  State_controller controller;
+  native_set_micros(1000000);
+  controller.set_auto_mode();
+  native_set_micros(2000000);
+  controller.set_auto_mode(); // no change, not logged
+  controller.set_error_mode();
+
+  TEST_ASSERT_EQUAL(2, controller.get_number_of_logged_transitions());
+  Mode_transition latest = controller.get_logged_transition(0);
+  TEST_ASSERT_EQUAL(2000, latest.time);
+  TEST_ASSERT_EQUAL(auto_mode, latest.previous_mode);
+  TEST_ASSERT_EQUAL(event_set_error_mode, latest.event);
+  TEST_ASSERT_EQUAL(error_mode, latest.mode);
+  Mode_transition first = controller.get_logged_transition(1);
+  TEST_ASSERT_EQUAL(1000, first.time);
+  TEST_ASSERT_EQUAL(step_mode, first.previous_mode);
+  TEST_ASSERT_EQUAL(auto_mode, first.mode);
+}
+
+void test_transition_log_keeps_the_latest() {
+  State_controller controller;
+  for (unsigned int i = 0; i < 3 * MODE_LOG_SIZE; i++) {
+    native_set_micros(1000ULL * i);
+    controller.toggle_step_auto_mode();
+  }
+  TEST_ASSERT_EQUAL(MODE_LOG_SIZE, controller.get_number_of_logged_transitions());
+  for (byte age = 0; age < MODE_LOG_SIZE; age++) {
+    TEST_ASSERT_EQUAL(3 * MODE_LOG_SIZE - 1 - age, controller.get_logged_transition(age).time);
+  }
+}
+
+// STEPS -----------------------------------------------------------------------
+void test_step_management() {
+  State_controller controller(3);
+  controller.switch_to_previous_step(); // stays at the first step
+  TEST_ASSERT_EQUAL(0, controller.get_current_step());
+  TEST_ASSERT_FALSE(controller.step_switch_has_happend());
+
+  controller.switch_to_next_step();
+  controller.switch_to_next_step();
+  TEST_ASSERT_EQUAL(2, controller.get_current_step());
+  TEST_ASSERT_TRUE(controller.step_switch_has_happend());
+  TEST_ASSERT_FALSE(controller.step_switch_has_happend()); // one time flag
+
+  controller.switch_to_next_step(); // wraps around
+  TEST_ASSERT_EQUAL(0, controller.get_current_step());
+  controller.set_current_step_to(1);
+  controller.switch_to_previous_step();
+  TEST_ASSERT_EQUAL(0, controller.get_current_step());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_initial_mode);
+  RUN_TEST(test_every_mode_and_event);
+  RUN_TEST(test_every_sequence_of_three_events);
+  RUN_TEST(test_handle_event_equals_setters);
+  RUN_TEST(test_invalid_event_is_ignored);
+  RUN_TEST(test_machine_running_is_independent);
+  RUN_TEST(test_transition_log);
+  RUN_TEST(test_transition_log_keeps_the_latest);
+  RUN_TEST(test_step_management);
+  return UNITY_END();
+}